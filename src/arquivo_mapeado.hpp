@@ -0,0 +1,46 @@
+#ifndef ARQUIVO_MAPEADO_HPP
+#define ARQUIVO_MAPEADO_HPP
+
+#include <cstddef>
+#include <string>
+#include <string_view>
+
+// Arquivo mapeado na memoria com mmap, pra ler (ou escrever) os bytes
+// direto sem copiar pra um buffer
+// Arquivo vazio nao eh mapeado, mas conta como aberto (tamanho 0)
+class ArquivoMapeado {
+private:
+    int fd;
+    char* dados;
+    size_t tamanho;
+    bool escrita;
+
+public:
+    ArquivoMapeado() : fd(-1), dados(nullptr), tamanho(0), escrita(false) {}
+    ~ArquivoMapeado() { fechar(); }
+
+    ArquivoMapeado(const ArquivoMapeado&) = delete;
+    ArquivoMapeado& operator=(const ArquivoMapeado&) = delete;
+
+    // Mapeia o arquivo so pra leitura, avisando o kernel que o acesso eh
+    // sequencial (readahead agressivo) e pedindo huge pages quando der
+    // Com sequencial = false o kernel so le as paginas acessadas (amostragem)
+    bool abrirLeitura(const std::string& caminho, bool sequencial = true);
+
+    // Cria (ou trunca) o arquivo ja com o tamanho final e mapeia pra escrita
+    // O espaco eh reservado no disco antes; se nao tiver espaco, falha aqui
+    // (quem chama volta pra escrita com streams)
+    bool criarEscrita(const std::string& caminho, size_t tamanhoFinal);
+
+    // Desfaz o mapeamento; na escrita, corta o arquivo em tamanhoFinal
+    // (quando sobrou espaco no fim) antes de fechar
+    bool finalizarEscrita(size_t tamanhoFinal);
+
+    void fechar();
+
+    std::string_view conteudo() const { return std::string_view(dados, tamanho); }
+    char* obterDados() { return dados; }
+    size_t obterTamanho() const { return tamanho; }
+};
+
+#endif // ARQUIVO_MAPEADO_HPP
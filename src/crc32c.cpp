@@ -0,0 +1,98 @@
+#include "crc32c.hpp"
+#include <cstring>
+
+#if defined(__x86_64__) && (defined(__GNUC__) || defined(__clang__))
+#include <nmmintrin.h>
+#define CRC32C_TEM_SSE42 1
+#endif
+
+namespace {
+
+// Polinomio 0x1EDC6F41 na forma refletida
+const uint32_t POLINOMIO = 0x82F63B78u;
+
+// 8 tabelas de 256 entradas pro slicing-by-8: a tabela k da o efeito
+// de um byte que ainda vai passar por mais k bytes
+struct TabelasCrc {
+    uint32_t t[8][256];
+
+    TabelasCrc() {
+        for (uint32_t i = 0; i < 256; ++i) {
+            uint32_t crc = i;
+            for (int bit = 0; bit < 8; ++bit) {
+                crc = (crc & 1) ? (crc >> 1) ^ POLINOMIO : crc >> 1;
+            }
+            t[0][i] = crc;
+        }
+        for (uint32_t i = 0; i < 256; ++i) {
+            for (int k = 1; k < 8; ++k) {
+                t[k][i] = (t[k - 1][i] >> 8) ^ t[0][t[k - 1][i] & 0xFF];
+            }
+        }
+    }
+};
+
+const TabelasCrc tabelas;
+
+#ifdef CRC32C_TEM_SSE42
+__attribute__((target("sse4.2")))
+uint32_t crc32cHardware(const unsigned char* p, size_t n, uint32_t crc) {
+    uint64_t c = crc;
+    // Processa 8 bytes por instrucao, o resto vai de byte em byte
+    while (n >= 8) {
+        uint64_t palavra;
+        std::memcpy(&palavra, p, 8);
+        c = _mm_crc32_u64(c, palavra);
+        p += 8;
+        n -= 8;
+    }
+    uint32_t c32 = static_cast<uint32_t>(c);
+    while (n > 0) {
+        c32 = _mm_crc32_u8(c32, *p++);
+        --n;
+    }
+    return c32;
+}
+
+const bool usaHardware = __builtin_cpu_supports("sse4.2");
+#else
+const bool usaHardware = false;
+#endif
+
+uint32_t crc32cSlicing(const unsigned char* p, size_t n, uint32_t crc) {
+    const auto& t = tabelas.t;
+    while (n >= 8) {
+        // Os 4 primeiros bytes se misturam com o crc atual, os outros 4 entram direto
+        uint32_t baixo = crc ^ (static_cast<uint32_t>(p[0]) | static_cast<uint32_t>(p[1]) << 8 |
+                                static_cast<uint32_t>(p[2]) << 16 | static_cast<uint32_t>(p[3]) << 24);
+        crc = t[7][baixo & 0xFF] ^ t[6][(baixo >> 8) & 0xFF] ^
+              t[5][(baixo >> 16) & 0xFF] ^ t[4][baixo >> 24] ^
+              t[3][p[4]] ^ t[2][p[5]] ^ t[1][p[6]] ^ t[0][p[7]];
+        p += 8;
+        n -= 8;
+    }
+    while (n > 0) {
+        crc = (crc >> 8) ^ t[0][(crc ^ *p++) & 0xFF];
+        --n;
+    }
+    return crc;
+}
+
+} // namespace
+
+uint32_t calcularCrc32cSoftware(const void* dados, size_t tamanho, uint32_t crc) {
+    return ~crc32cSlicing(static_cast<const unsigned char*>(dados), tamanho, ~crc);
+}
+
+uint32_t calcularCrc32c(const void* dados, size_t tamanho, uint32_t crc) {
+#ifdef CRC32C_TEM_SSE42
+    if (usaHardware) {
+        return ~crc32cHardware(static_cast<const unsigned char*>(dados), tamanho, ~crc);
+    }
+#endif
+    return calcularCrc32cSoftware(dados, tamanho, crc);
+}
+
+bool crc32cTemHardware() {
+    return usaHardware;
+}
@@ -0,0 +1,18 @@
+#ifndef CRC32C_HPP
+#define CRC32C_HPP
+
+#include <cstddef>
+#include <cstdint>
+
+// CRC32C (polinomio de Castagnoli), usado como checksum dos blocos do .huf
+// Usa a instrucao crc32 do SSE4.2 quando a CPU tem, senao cai no slicing-by-8
+// Pra continuar um calculo anterior basta passar o crc ja calculado
+uint32_t calcularCrc32c(const void* dados, size_t tamanho, uint32_t crc = 0);
+
+// Versao so em software (slicing-by-8), exposta pra comparar com a de hardware
+uint32_t calcularCrc32cSoftware(const void* dados, size_t tamanho, uint32_t crc = 0);
+
+// Diz se o calculo esta usando a instrucao do SSE4.2
+bool crc32cTemHardware();
+
+#endif // CRC32C_HPP
@@ -0,0 +1,58 @@
+#ifndef FILA_LIMITADA_HPP
+#define FILA_LIMITADA_HPP
+
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+
+// Fila com capacidade fixa pra ligar as etapas do pipeline (leitura,
+// codificacao e escrita), cada uma na sua thread
+// Com capacidade 2 vira um double buffer: a etapa da frente trabalha num
+// item enquanto o proximo ja esta pronto esperando
+template <typename T>
+class FilaLimitada {
+private:
+    std::mutex trava;
+    std::condition_variable temItem;
+    std::condition_variable temEspaco;
+    std::deque<T> itens;
+    size_t capacidade;
+    bool fechada;
+
+public:
+    explicit FilaLimitada(size_t capacidade) : capacidade(capacidade), fechada(false) {}
+
+    // Bloqueia enquanto a fila estiver cheia
+    // Retorna false se a fila foi fechada (ninguem mais vai consumir)
+    bool colocar(T item) {
+        std::unique_lock<std::mutex> lock(trava);
+        temEspaco.wait(lock, [this] { return itens.size() < capacidade || fechada; });
+        if (fechada) return false;
+        itens.push_back(std::move(item));
+        temItem.notify_one();
+        return true;
+    }
+
+    // Bloqueia enquanto a fila estiver vazia
+    // Retorna false quando a fila foi fechada e nao sobrou nada
+    bool retirar(T& item) {
+        std::unique_lock<std::mutex> lock(trava);
+        temItem.wait(lock, [this] { return !itens.empty() || fechada; });
+        if (itens.empty()) return false;
+        item = std::move(itens.front());
+        itens.pop_front();
+        temEspaco.notify_one();
+        return true;
+    }
+
+    // Acorda todo mundo: quem produz para de colocar, quem consome
+    // esvazia o que sobrou e para
+    void fechar() {
+        std::lock_guard<std::mutex> lock(trava);
+        fechada = true;
+        temItem.notify_all();
+        temEspaco.notify_all();
+    }
+};
+
+#endif // FILA_LIMITADA_HPP
@@ -1,3 +1,6 @@
+#include "arquivo_mapeado.hpp"
+#include "huffman_tree.hpp"
+#include "modelo.hpp"
 #include <iostream>
 #include <fstream>
 #include <map>
@@ -6,6 +9,14 @@
 #include <filesystem>
 #include <algorithm>
 #include <iomanip>
+#include <iterator>
+#include <string_view>
+#include <cmath>
+#include <cctype>
+#include <climits>
+#include <cstdint>
+#include <cstdlib>
+#include <random>
 
 namespace fs = std::filesystem;
 
@@ -33,105 +44,437 @@ const std::vector<std::string> CPP_KEYWORDS = {
     "include", "define", "ifdef", "ifndef", "endif", "pragma"
 };
 
-bool ehPalavraChave(const std::string& word) {
-    return std::find(CPP_KEYWORDS.begin(), CPP_KEYWORDS.end(), word) != CPP_KEYWORDS.end();
+// Posicao da palavra em CPP_KEYWORDS, ou -1 se nao for palavra-chave
+int indicePalavraChave(std::string_view word) {
+    auto it = std::find(CPP_KEYWORDS.begin(), CPP_KEYWORDS.end(), word);
+    return it == CPP_KEYWORDS.end() ? -1 : static_cast<int>(it - CPP_KEYWORDS.begin());
 }
 
-// Funcao pra quebrar o texto em tokens
-// Se for keyword, trata como simbolo unico
-// Se nao, separa em caracteres individuais
-std::vector<std::string> tokenizar(const std::string& text) {
-    std::vector<std::string> tokens;
-    std::string palavra_atual;
+// Contagem de cada simbolo possivel: os 256 bytes e depois as palavras-chave,
+// na ordem de CPP_KEYWORDS
+// 64 bits: um corpus de terabytes (ou uma amostra extrapolada) passa do int
+using Histograma = std::vector<int64_t>;
+
+Histograma novoHistograma() {
+    return Histograma(256 + CPP_KEYWORDS.size(), 0);
+}
+
+// Amostragem (--sample): os arquivos sao divididos em blocos desse tamanho
+// (arquivo menor eh um bloco so) e cada bloco eh sorteado pro treino, pra
+// validacao ou fica de fora
+const size_t BLOCO_AMOSTRA = 64 * 1024;
+// A validacao eh dividida em lotes pra calcular a margem de erro da perda
+const size_t NUM_LOTES = 32;
+// Semente fixa: a mesma fracao sorteia sempre os mesmos blocos
+const uint64_t SEMENTE_AMOSTRA = 0x48554646;
+
+bool ehCaractereDePalavra(unsigned char c) {
+    return std::isalnum(c) || c == '_';
+}
+
+// Conta os tokens direto sobre os bytes do texto, sem copiar nada
+// Se for keyword, conta como simbolo unico
+// Se nao, conta cada caractere separado
+void contarTokens(std::string_view text, Histograma& histograma) {
+    int64_t* porByte = histograma.data();
+    int64_t* porPalavra = histograma.data() + 256;
+    size_t inicioPalavra = 0;
     
-    for (size_t i = 0; i < text.length(); ++i) {
-        char c = text[i];
+    for (size_t i = 0; i <= text.length(); ++i) {
+        unsigned char c = i < text.length() ? static_cast<unsigned char>(text[i]) : 0;
+        if (i < text.length() && ehCaractereDePalavra(c)) continue;
         
-        if (std::isalnum(c) || c == '_') {
-            palavra_atual += c;
-        } else {
-            if (!palavra_atual.empty()) {
-                if (ehPalavraChave(palavra_atual)) {
-                    tokens.push_back(palavra_atual);
-                } else {
-                    for (char ch : palavra_atual) {
-                        tokens.push_back(std::string(1, ch));
-                    }
-                }
-                palavra_atual.clear();
+        // Fechou uma palavra (pode ser vazia)
+        std::string_view palavra = text.substr(inicioPalavra, i - inicioPalavra);
+        if (!palavra.empty()) {
+            int indice = indicePalavraChave(palavra);
+            if (indice >= 0) {
+                porPalavra[indice]++;
+            } else {
+                for (char ch : palavra) porByte[static_cast<unsigned char>(ch)]++;
             }
-            
-            tokens.push_back(std::string(1, c));
         }
+        
+        if (i < text.length()) porByte[c]++;
+        inicioPalavra = i + 1;
     }
-    
-    if (!palavra_atual.empty()) {
-        if (ehPalavraChave(palavra_atual)) {
-            tokens.push_back(palavra_atual);
-        } else {
-            for (char ch : palavra_atual) {
-                tokens.push_back(std::string(1, ch));
-            }
-        }
+}
+
+// Passa as contagens do histograma pro map de simbolo -> frequencia
+void adicionarAoMapa(const Histograma& histograma, std::map<std::string, int64_t>& frequencies) {
+    for (int b = 0; b < 256; ++b) {
+        if (histograma[b] > 0) frequencies[std::string(1, static_cast<char>(b))] += histograma[b];
+    }
+    for (size_t k = 0; k < CPP_KEYWORDS.size(); ++k) {
+        if (histograma[256 + k] > 0) frequencies[CPP_KEYWORDS[k]] += histograma[256 + k];
     }
-    
-    return tokens;
 }
 
 // Le o arquivo e conta quantas vezes cada simbolo aparece
-void contarFrequencias(const std::string& filename, std::map<std::string, int>& frequencies) {
-    std::ifstream file(filename);
+// Mapeia o arquivo com mmap e tokeniza direto nos bytes mapeados; se nao
+// der pra mapear (pipe, sistema de arquivos estranho), le com ifstream
+void contarFrequencias(const std::string& filename, Histograma& histograma) {
+    ArquivoMapeado mapa;
+    if (mapa.abrirLeitura(filename)) {
+        contarTokens(mapa.conteudo(), histograma);
+        return;
+    }
+    
+    std::ifstream file(filename, std::ios::binary);
     if (!file.is_open()) {
         std::cerr << "Erro ao abrir arquivo: " << filename << std::endl;
         return;
     }
     
-    std::string linha;
-    while (std::getline(file, linha)) {
-        linha += '\n';
+    std::string conteudo((std::istreambuf_iterator<char>(file)), std::istreambuf_iterator<char>());
+    contarTokens(conteudo, histograma);
+    file.close();
+}
+
+// Resultado da amostragem: contagens dos blocos de treino e dos lotes de
+// validacao (que nao entram no modelo), mais quantos bytes cada um leu
+struct Amostra {
+    Histograma treino = novoHistograma();
+    std::vector<Histograma> lotes = std::vector<Histograma>(NUM_LOTES, novoHistograma());
+    std::vector<uint64_t> bytesPorLote = std::vector<uint64_t>(NUM_LOTES, 0);
+    uint64_t bytesTreino = 0;
+    uint64_t bytesValidacao = 0;
+    uint64_t bytesTotais = 0;
+};
+
+// Empurra o limite de um bloco pro fim da palavra em que ele cai, pra
+// nenhuma palavra-chave ficar cortada entre dois blocos
+size_t limiteDoBloco(std::string_view text, size_t pos) {
+    while (pos > 0 && pos < text.size() &&
+           ehCaractereDePalavra(text[pos - 1]) && ehCaractereDePalavra(text[pos])) {
+        ++pos;
+    }
+    return pos;
+}
+
+/**
+ * Conta só os blocos sorteados: cada um vai pro treino com probabilidade
+ * fracao e pra validação com probabilidade fracaoValidacao (sem repetir)
+ * O sorteio é feito antes de abrir o arquivo, então arquivo sem bloco
+ * sorteado nem é lido, e o mapeamento sem readahead só lê as páginas dos
+ * blocos sorteados
+ */
+void contarAmostra(const std::vector<fs::path>& arquivos, double fracao, double fracaoValidacao,
+                   Amostra& amostra) {
+    enum Destino { FORA, TREINO, VALIDACAO };
+    std::mt19937_64 sorteio(SEMENTE_AMOSTRA);
+    std::uniform_real_distribution<double> uniforme(0.0, 1.0);
+    size_t proximoLote = 0;
+    
+    for (const auto& arquivo : arquivos) {
+        std::error_code erro;
+        uint64_t tamanho = fs::file_size(arquivo, erro);
+        if (erro) tamanho = 0;
+        amostra.bytesTotais += tamanho;
         
-        auto tokens = tokenizar(linha);
+        size_t numBlocos = std::max<size_t>(1, (tamanho + BLOCO_AMOSTRA - 1) / BLOCO_AMOSTRA);
+        std::vector<Destino> destinos(numBlocos);
+        bool algumSorteado = false;
+        for (Destino& destino : destinos) {
+            double u = uniforme(sorteio);
+            destino = u < fracao ? TREINO : (u >= 1.0 - fracaoValidacao ? VALIDACAO : FORA);
+            algumSorteado = algumSorteado || destino != FORA;
+        }
+        if (!algumSorteado) continue;
+        
+        std::cout << "Processando: " << arquivo.string() << std::endl;
+        ArquivoMapeado mapa;
+        std::string conteudo;
+        std::string_view texto;
+        if (mapa.abrirLeitura(arquivo.string(), false)) {
+            texto = mapa.conteudo();
+        } else {
+            std::ifstream file(arquivo, std::ios::binary);
+            if (!file.is_open()) {
+                std::cerr << "Erro ao abrir arquivo: " << arquivo.string() << std::endl;
+                continue;
+            }
+            conteudo.assign(std::istreambuf_iterator<char>(file), std::istreambuf_iterator<char>());
+            texto = conteudo;
+        }
         
-        for (const auto& token : tokens) {
-            frequencies[token]++;
+        for (size_t b = 0; b < destinos.size(); ++b) {
+            if (destinos[b] == FORA) continue;
+            size_t inicio = limiteDoBloco(texto, std::min(texto.size(), b * BLOCO_AMOSTRA));
+            size_t fim = limiteDoBloco(texto, std::min(texto.size(), (b + 1) * BLOCO_AMOSTRA));
+            std::string_view bloco = texto.substr(inicio, fim - inicio);
+            
+            if (destinos[b] == TREINO) {
+                contarTokens(bloco, amostra.treino);
+                amostra.bytesTreino += bloco.size();
+            } else {
+                size_t lote = proximoLote++ % NUM_LOTES;
+                contarTokens(bloco, amostra.lotes[lote]);
+                amostra.bytesPorLote[lote] += bloco.size();
+                amostra.bytesValidacao += bloco.size();
+            }
         }
     }
+}
+
+// Soma as contagens da amostra pesando 1/fracao (estimativa do corpus todo)
+void somarExtrapolado(const Histograma& histograma, double fracao, std::vector<double>& estimado) {
+    for (size_t s = 0; s < histograma.size(); ++s) estimado[s] += histograma[s] / fracao;
+}
+
+// Arredonda a estimativa sem zerar símbolo visto
+// Todo byte fica com pelo menos 1: um byte que só aparece nos blocos que não
+// foram sorteados ainda precisa ter código
+Histograma arredondar(const std::vector<double>& estimado) {
+    Histograma histograma = novoHistograma();
+    for (size_t s = 0; s < estimado.size(); ++s) {
+        if (estimado[s] > 0) {
+            histograma[s] = std::max<int64_t>(1, std::llround(estimado[s]));
+        } else if (s < 256) {
+            histograma[s] = 1;
+        }
+    }
+    return histograma;
+}
+
+// Maior total que uma tabela pode ter: a árvore de Huffman soma as
+// frequências em int até a raiz, então sobra folga pro arredondamento
+const int64_t MAX_TOTAL_TABELA = INT_MAX / 2;
+
+// Passa as contagens pra frequências de tabela; se o total não couber em
+// MAX_TOTAL_TABELA, divide tudo pelo mesmo fator sem zerar nenhum símbolo
+// (só a proporção entre eles importa pros códigos)
+std::map<std::string, int> paraTabela(const std::map<std::string, int64_t>& contagens) {
+    int64_t total = 0;
+    for (const auto& pair : contagens) total += pair.second;
+    double fator = total > MAX_TOTAL_TABELA ? static_cast<double>(MAX_TOTAL_TABELA) / total : 1.0;
     
-    file.close();
+    std::map<std::string, int> tabela;
+    for (const auto& pair : contagens) {
+        tabela.emplace(pair.first, static_cast<int>(std::max<int64_t>(1, std::llround(pair.second * fator))));
+    }
+    return tabela;
+}
+
+// Tamanho do código de cada símbolo (na ordem do Histograma), -1 se não tem
+std::vector<int> comprimentosDosCodigos(const Histograma& histograma) {
+    std::map<std::string, int64_t> frequencies;
+    adicionarAoMapa(histograma, frequencies);
+    HuffmanTree tree;
+    tree.construirArvore(paraTabela(frequencies));
+    
+    std::vector<int> comprimentos(histograma.size(), -1);
+    for (const auto& pair : tree.obterCodigos()) {
+        int indice = pair.first.size() == 1 ? static_cast<unsigned char>(pair.first[0])
+                                            : 256 + indicePalavraChave(pair.first);
+        // Um símbolo só na tabela fica com código vazio, mas gasta 1 bit
+        comprimentos[indice] = std::max<int>(1, pair.second.size());
+    }
+    return comprimentos;
+}
+
+// Bits que os códigos gastam num lote tokenizado
+// Palavra-chave fora do modelo vira os seus caracteres, como no compressor
+// (todo byte tem código, ver arredondar)
+double bitsNoModelo(const Histograma& lote, const std::vector<int>& comprimentos) {
+    std::vector<double> porByte(lote.begin(), lote.begin() + 256);
+    double bits = 0.0;
+    for (size_t k = 0; k < CPP_KEYWORDS.size(); ++k) {
+        if (lote[256 + k] == 0) continue;
+        if (comprimentos[256 + k] >= 0) {
+            bits += static_cast<double>(lote[256 + k]) * comprimentos[256 + k];
+        } else {
+            for (char ch : CPP_KEYWORDS[k]) porByte[static_cast<unsigned char>(ch)] += lote[256 + k];
+        }
+    }
+    for (int b = 0; b < 256; ++b) {
+        bits += porByte[b] * comprimentos[b];
+    }
+    return bits;
 }
 
 /**
- * Processa todos os arquivos de um diretório recursivamente
+ * Estima quanto a taxa de compressão piora por treinar só com a amostra
+ * Nos lotes de validação (que não entraram no treino), compara o modelo da
+ * amostra com um de referência montado com treino + validação, que é a
+ * melhor estimativa que dá pra ter do modelo do corpus todo
+ * A margem é de ~95%: 1,96 desvio padrão da perda média entre os lotes
  */
-void processarDiretorio(const std::string& dirPath, std::map<std::string, int>& frequencies) {
+void estimarPerda(const Amostra& amostra, double fracao, double fracaoValidacao) {
+    std::cout << "\n=== Amostragem ===" << std::endl;
+    std::cout << std::fixed << std::setprecision(2);
+    std::cout << "Lidos: " << amostra.bytesTreino + amostra.bytesValidacao << " de " << amostra.bytesTotais
+              << " bytes (treino " << amostra.bytesTreino << ", validação " << amostra.bytesValidacao << ")" << std::endl;
+    if (amostra.bytesValidacao == 0) {
+        std::cout << "Sem blocos de validação, perda não estimada (use uma fração menor que 1)" << std::endl;
+        return;
+    }
+    
+    std::vector<double> estimado(amostra.treino.size(), 0.0);
+    somarExtrapolado(amostra.treino, fracao, estimado);
+    std::vector<int> comprimentosAmostra = comprimentosDosCodigos(arredondar(estimado));
+    for (const Histograma& lote : amostra.lotes) somarExtrapolado(lote, fracaoValidacao, estimado);
+    std::vector<int> comprimentosReferencia = comprimentosDosCodigos(arredondar(estimado));
+    
+    double bitsAmostra = 0.0;
+    double bitsReferencia = 0.0;
+    std::vector<double> perdas;
+    for (size_t l = 0; l < NUM_LOTES; ++l) {
+        if (amostra.bytesPorLote[l] == 0) continue;
+        double a = bitsNoModelo(amostra.lotes[l], comprimentosAmostra);
+        double r = bitsNoModelo(amostra.lotes[l], comprimentosReferencia);
+        bitsAmostra += a;
+        bitsReferencia += r;
+        perdas.push_back((a - r) / (8.0 * amostra.bytesPorLote[l]) * 100.0);
+    }
+    
+    double bitsOriginais = 8.0 * amostra.bytesValidacao;
+    double taxaAmostra = (1.0 - bitsAmostra / bitsOriginais) * 100.0;
+    double taxaReferencia = (1.0 - bitsReferencia / bitsOriginais) * 100.0;
+    std::cout << "Taxa estimada com o modelo da amostra: " << taxaAmostra << "%" << std::endl;
+    std::cout << "Taxa estimada com o modelo do corpus:  " << taxaReferencia << "%" << std::endl;
+    std::cout << "Perda estimada: " << taxaReferencia - taxaAmostra;
+    if (perdas.size() > 1) {
+        double media = 0.0;
+        for (double p : perdas) media += p;
+        media /= perdas.size();
+        double variancia = 0.0;
+        for (double p : perdas) variancia += (p - media) * (p - media);
+        variancia /= perdas.size() - 1;
+        std::cout << " ± " << 1.96 * std::sqrt(variancia / perdas.size());
+    }
+    std::cout << " pontos percentuais" << std::endl;
+}
+
+/**
+ * Lista os arquivos C++ de um diretório recursivamente, em ordem
+ */
+std::vector<fs::path> listarArquivos(const std::string& dirPath) {
+    std::vector<fs::path> arquivos;
     try {
         for (const auto& entry : fs::recursive_directory_iterator(dirPath)) {
             if (entry.is_regular_file()) {
                 std::string ext = entry.path().extension().string();
                 // Processa apenas arquivos C++
                 if (ext == ".cpp" || ext == ".hpp" || ext == ".h" || ext == ".cc" || ext == ".cxx") {
-                    std::cout << "Processando: " << entry.path().string() << std::endl;
-                    contarFrequencias(entry.path().string(), frequencies);
+                    arquivos.push_back(entry.path());
                 }
             }
         }
     } catch (const fs::filesystem_error& e) {
         std::cerr << "Erro ao processar diretório: " << e.what() << std::endl;
     }
+    std::sort(arquivos.begin(), arquivos.end());
+    return arquivos;
 }
 
 /**
- * Salva a tabela de frequências em um arquivo
+ * Grupo do arquivo pelo critério: a extensão, ou o primeiro diretório
+ * abaixo da raiz ("." pros arquivos direto na raiz)
  */
-void salvarTabelaFrequencias(const std::map<std::string, int>& frequencies, const std::string& outputFile) {
-    std::ofstream file(outputFile);
-    if (!file.is_open()) {
-        std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
-        return;
+std::string grupoDoArquivo(const fs::path& arquivo, const std::string& raiz, const std::string& criterio) {
+    if (criterio == "extensao") return arquivo.extension().string();
+    
+    fs::path relativo = arquivo.lexically_relative(raiz);
+    if (relativo.empty() || !relativo.has_parent_path()) return ".";
+    return relativo.begin()->string();
+}
+
+/**
+ * Agrupa os arquivos em até K grupos de histogramas parecidos (k-means com
+ * entropia cruzada no lugar da distância): cada arquivo vai pro grupo em que
+ * custaria menos bits, e o grupo é a soma dos histogramas dos seus arquivos
+ * Os centros iniciais são o maior arquivo e depois, um por vez, o arquivo
+ * que sai mais caro (em bits por símbolo) nos grupos que já existem
+ * Retorna o grupo de cada arquivo, numerados a partir de 0 sem buracos
+ */
+std::vector<int> agruparPorHistograma(const std::vector<Histograma>& histogramas, size_t K) {
+    size_t n = histogramas.size();
+    size_t numSimbolos = histogramas.empty() ? 0 : histogramas[0].size();
+    std::vector<double> tokens(n, 0.0);
+    for (size_t i = 0; i < n; ++i) {
+        for (int64_t c : histogramas[i]) tokens[i] += c;
+    }
+    
+    // log2 da probabilidade de cada símbolo no grupo, com meia contagem a
+    // mais pra símbolo que o grupo nunca viu não custar infinito
+    auto log2Probabilidades = [&](const std::vector<double>& soma) {
+        double total = 0.0;
+        for (double c : soma) total += c;
+        std::vector<double> lp(numSimbolos);
+        for (size_t s = 0; s < numSimbolos; ++s) {
+            lp[s] = std::log2((soma[s] + 0.5) / (total + 0.5 * numSimbolos));
+        }
+        return lp;
+    };
+    auto custo = [&](size_t arquivo, const std::vector<double>& lp) {
+        double bits = 0.0;
+        for (size_t s = 0; s < numSimbolos; ++s) bits -= histogramas[arquivo][s] * lp[s];
+        return bits;
+    };
+    auto centroDoArquivo = [&](size_t arquivo) {
+        return log2Probabilidades(std::vector<double>(histogramas[arquivo].begin(), histogramas[arquivo].end()));
+    };
+    
+    std::vector<std::vector<double>> centros;
+    if (n > 0) centros.push_back(centroDoArquivo(std::max_element(tokens.begin(), tokens.end()) - tokens.begin()));
+    while (centros.size() < std::min(K, n)) {
+        size_t pior = 0;
+        double maiorCusto = -1.0;
+        for (size_t i = 0; i < n; ++i) {
+            if (tokens[i] == 0) continue;
+            double menor = HUGE_VAL;
+            for (const auto& lp : centros) menor = std::min(menor, custo(i, lp) / tokens[i]);
+            if (menor > maiorCusto) {
+                maiorCusto = menor;
+                pior = i;
+            }
+        }
+        if (maiorCusto <= 0.0) break;
+        centros.push_back(centroDoArquivo(pior));
+    }
+    
+    std::vector<int> grupo(n, -1);
+    for (int iteracao = 0; iteracao < 20; ++iteracao) {
+        bool mudou = false;
+        for (size_t i = 0; i < n; ++i) {
+            int melhor = 0;
+            double menor = HUGE_VAL;
+            for (size_t c = 0; c < centros.size(); ++c) {
+                double bits = custo(i, centros[c]);
+                if (bits < menor) {
+                    menor = bits;
+                    melhor = static_cast<int>(c);
+                }
+            }
+            mudou = mudou || grupo[i] != melhor;
+            grupo[i] = melhor;
+        }
+        if (!mudou) break;
+        
+        std::vector<std::vector<double>> somas(centros.size(), std::vector<double>(numSimbolos, 0.0));
+        for (size_t i = 0; i < n; ++i) {
+            for (size_t s = 0; s < numSimbolos; ++s) somas[grupo[i]][s] += histogramas[i][s];
+        }
+        for (size_t c = 0; c < centros.size(); ++c) centros[c] = log2Probabilidades(somas[c]);
     }
     
+    // Renumera sem os grupos que ficaram vazios
+    std::vector<int> novoNumero(centros.size(), -1);
+    int proximo = 0;
+    for (int& g : grupo) {
+        if (novoNumero[g] < 0) novoNumero[g] = proximo++;
+        g = novoNumero[g];
+    }
+    return grupo;
+}
+
+/**
+ * Escreve as linhas da tabela (símbolo|frequência), já na escala da tabela
+ */
+void escreverTabela(std::ostream& file, const std::map<std::string, int64_t>& frequencies) {
     // Formato: símbolo|frequência
-    for (const auto& pair : frequencies) {
+    for (const auto& pair : paraTabela(frequencies)) {
         std::string symbol = pair.first;
         // Escapa caracteres especiais
         if (symbol == "\n") symbol = "\\n";
@@ -141,17 +484,48 @@ void salvarTabelaFrequencias(const std::map<std::string, int>& frequencies, cons
         
         file << symbol << "|" << pair.second << "\n";
     }
+}
+
+/**
+ * Salva a tabela de frequências em um arquivo
+ */
+void salvarTabelaFrequencias(const std::map<std::string, int64_t>& frequencies, const std::string& outputFile) {
+    std::ofstream file(outputFile);
+    if (!file.is_open()) {
+        std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
+        return;
+    }
     
+    escreverTabela(file, frequencies);
     file.close();
     std::cout << "\nTabela de frequências salva em: " << outputFile << std::endl;
 }
 
+/**
+ * Salva o pacote de modelos: cada tabela começa com uma linha [nome]
+ */
+void salvarPacoteFrequencias(const std::vector<std::pair<std::string, std::map<std::string, int64_t>>>& grupos,
+                             const std::string& outputFile) {
+    std::ofstream file(outputFile);
+    if (!file.is_open()) {
+        std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
+        return;
+    }
+    
+    for (const auto& grupo : grupos) {
+        file << "[" << grupo.first << "]\n";
+        escreverTabela(file, grupo.second);
+    }
+    file.close();
+    std::cout << "\nPacote com " << grupos.size() << " modelos salvo em: " << outputFile << std::endl;
+}
+
 /**
  * Imprime estatísticas da tabela de frequências
  */
-void imprimirEstatisticas(const std::map<std::string, int>& frequencies) {
+void imprimirEstatisticas(const std::map<std::string, int64_t>& frequencies) {
     int totalSymbols = 0;
-    int totalOccurrences = 0;
+    int64_t totalOccurrences = 0;
     
     for (const auto& pair : frequencies) {
         totalSymbols++;
@@ -163,7 +537,7 @@ void imprimirEstatisticas(const std::map<std::string, int>& frequencies) {
     std::cout << "Total de ocorrências: " << totalOccurrences << std::endl;
     
     // Top 10 símbolos mais frequentes
-    std::vector<std::pair<std::string, int>> sorted(frequencies.begin(), frequencies.end());
+    std::vector<std::pair<std::string, int64_t>> sorted(frequencies.begin(), frequencies.end());
     std::sort(sorted.begin(), sorted.end(), 
               [](const auto& a, const auto& b) { return a.second > b.second; });
     
@@ -186,33 +560,117 @@ void imprimirEstatisticas(const std::map<std::string, int>& frequencies) {
     }
 }
 
+void imprimirUso(const char* programName) {
+    std::cout << "Uso: " << programName << " <arquivo_ou_diretório> [arquivo_saída] [--modelos critério | --sample fração]" << std::endl;
+    std::cout << "\nCom --modelos, gera um pacote com um modelo por grupo de arquivos:" << std::endl;
+    std::cout << "  extensao    um modelo por extensão (.cpp, .hpp, ...)" << std::endl;
+    std::cout << "  diretorio   um modelo por diretório de primeiro nível" << std::endl;
+    std::cout << "  K           até K modelos, agrupando arquivos com histogramas parecidos" << std::endl;
+    std::cout << "\nCom --sample, lê só essa fração (0 a 1) dos blocos de 64 KiB, extrapola as" << std::endl;
+    std::cout << "contagens e estima a perda de taxa numa outra amostra, separada do treino" << std::endl;
+    std::cout << "\nExemplos:" << std::endl;
+    std::cout << "  " << programName << " exemplo.cpp frequencias.txt" << std::endl;
+    std::cout << "  " << programName << " ./src/ frequencias.txt" << std::endl;
+    std::cout << "  " << programName << " ./src/ modelos.txt --modelos 4" << std::endl;
+    std::cout << "  " << programName << " /corpus/ frequencias.txt --sample 0.01" << std::endl;
+}
+
 int main(int argc, char* argv[]) {
-    if (argc < 2) {
-        std::cout << "Uso: " << argv[0] << " <arquivo_ou_diretório> [arquivo_saída]" << std::endl;
-        std::cout << "\nExemplos:" << std::endl;
-        std::cout << "  " << argv[0] << " exemplo.cpp frequencias.txt" << std::endl;
-        std::cout << "  " << argv[0] << " ./src/ frequencias.txt" << std::endl;
-        return 1;
+    std::vector<std::string> posicionais;
+    std::string criterio;
+    double fracao = 0.0;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg == "--modelos" && i + 1 < argc) {
+            criterio = argv[++i];
+        } else if (arg == "--sample" && i + 1 < argc) {
+            char* fim;
+            fracao = std::strtod(argv[++i], &fim);
+            if (*fim != '\0' || !(fracao > 0.0 && fracao <= 1.0)) {
+                std::cerr << "Erro: Fração inválida: " << argv[i] << " (use um valor entre 0 e 1)" << std::endl;
+                return 1;
+            }
+        } else if (arg.rfind("--", 0) == 0) {
+            std::cerr << "Erro: Opção inválida: " << arg << std::endl;
+            imprimirUso(argv[0]);
+            return 1;
+        } else {
+            posicionais.push_back(arg);
+        }
     }
     
-    std::string inputPath = argv[1];
-    std::string outputFile = argc > 2 ? argv[2] : "frequencias.txt";
+    bool porHistograma = !criterio.empty() && std::all_of(criterio.begin(), criterio.end(), ::isdigit);
+    if (posicionais.empty() ||
+        (!criterio.empty() && criterio != "extensao" && criterio != "diretorio" &&
+         !(porHistograma && std::stoul(criterio) >= 1 && std::stoul(criterio) <= MAX_MODELOS))) {
+        imprimirUso(argv[0]);
+        return 1;
+    }
+    if (fracao > 0.0 && !criterio.empty()) {
+        std::cerr << "Erro: --sample não pode ser usado junto com --modelos" << std::endl;
+        return 1;
+    }
     
-    std::map<std::string, int> frequencies;
+    std::string inputPath = posicionais[0];
+    std::string outputFile = posicionais.size() > 1 ? posicionais[1] : "frequencias.txt";
     
     std::cout << "=== Contador de Frequências de Símbolos ===" << std::endl;
     std::cout << "Analisando: " << inputPath << std::endl << std::endl;
     
     // Verifica se é arquivo ou diretório
+    std::vector<fs::path> arquivos;
     if (fs::is_directory(inputPath)) {
-        processarDiretorio(inputPath, frequencies);
+        arquivos = listarArquivos(inputPath);
     } else if (fs::is_regular_file(inputPath)) {
-        contarFrequencias(inputPath, frequencies);
+        arquivos.push_back(inputPath);
     } else {
         std::cerr << "Erro: Caminho inválido: " << inputPath << std::endl;
         return 1;
     }
     
+    // Amostragem: conta só uma fração dos blocos e salva as contagens
+    // extrapoladas; outra fração do mesmo tamanho (ou o resto, se a fração
+    // passar da metade) serve de validação
+    if (fracao > 0.0) {
+        double fracaoValidacao = std::min(fracao, 1.0 - fracao);
+        Amostra amostra;
+        contarAmostra(arquivos, fracao, fracaoValidacao, amostra);
+        if (amostra.bytesTreino == 0) {
+            std::cerr << "Erro: Nenhum bloco sorteado para o treino! Aumente a fração." << std::endl;
+            return 1;
+        }
+        
+        std::vector<double> estimado(amostra.treino.size(), 0.0);
+        somarExtrapolado(amostra.treino, fracao, estimado);
+        std::map<std::string, int64_t> frequencies;
+        adicionarAoMapa(arredondar(estimado), frequencies);
+        imprimirEstatisticas(frequencies);
+        salvarTabelaFrequencias(frequencies, outputFile);
+        estimarPerda(amostra, fracao, fracaoValidacao);
+        return 0;
+    }
+    
+    // Conta cada arquivo; com grupos, guarda o histograma de cada grupo
+    // (ou de cada arquivo, pro agrupamento por histograma)
+    Histograma total = novoHistograma();
+    std::vector<Histograma> histogramas;
+    std::map<std::string, Histograma> porGrupo;
+    for (const auto& arquivo : arquivos) {
+        std::cout << "Processando: " << arquivo.string() << std::endl;
+        Histograma histograma = novoHistograma();
+        contarFrequencias(arquivo.string(), histograma);
+        for (size_t s = 0; s < total.size(); ++s) total[s] += histograma[s];
+        
+        if (porHistograma) {
+            histogramas.push_back(std::move(histograma));
+        } else if (!criterio.empty()) {
+            Histograma& grupo = porGrupo.try_emplace(grupoDoArquivo(arquivo, inputPath, criterio), novoHistograma()).first->second;
+            for (size_t s = 0; s < grupo.size(); ++s) grupo[s] += histograma[s];
+        }
+    }
+    
+    std::map<std::string, int64_t> frequencies;
+    adicionarAoMapa(total, frequencies);
     if (frequencies.empty()) {
         std::cerr << "Nenhum símbolo encontrado!" << std::endl;
         return 1;
@@ -221,9 +679,58 @@ int main(int argc, char* argv[]) {
     // Imprime estatísticas
     imprimirEstatisticas(frequencies);
     
-    // Salva a tabela
-    salvarTabelaFrequencias(frequencies, outputFile);
+    if (criterio.empty()) {
+        // Salva a tabela
+        salvarTabelaFrequencias(frequencies, outputFile);
+        return 0;
+    }
+    
+    // Monta as tabelas de cada grupo
+    std::vector<std::pair<std::string, std::map<std::string, int64_t>>> grupos;
+    if (porHistograma) {
+        std::vector<int> grupoDoArquivo = agruparPorHistograma(histogramas, std::stoul(criterio));
+        int numGrupos = grupoDoArquivo.empty() ? 0 : *std::max_element(grupoDoArquivo.begin(), grupoDoArquivo.end()) + 1;
+        for (int g = 0; g < numGrupos; ++g) grupos.emplace_back("grupo" + std::to_string(g + 1), std::map<std::string, int64_t>());
+        for (size_t i = 0; i < histogramas.size(); ++i) {
+            adicionarAoMapa(histogramas[i], grupos[grupoDoArquivo[i]].second);
+        }
+    } else {
+        for (const auto& grupo : porGrupo) {
+            grupos.emplace_back(grupo.first, std::map<std::string, int64_t>());
+            adicionarAoMapa(grupo.second, grupos.back().second);
+        }
+    }
+    grupos.erase(std::remove_if(grupos.begin(), grupos.end(),
+                                [](const auto& grupo) { return grupo.second.empty(); }),
+                 grupos.end());
+    
+    // Todo modelo recebe (com frequência mínima) os bytes e as palavras-chave
+    // que apareceram em qualquer arquivo: um bloco misturado sempre pode usar
+    // qualquer um, e o texto é tokenizado igual seja qual for o modelo
+    for (auto& grupo : grupos) {
+        for (int b = 0; b < 256; ++b) {
+            if (total[b] > 0) grupo.second.emplace(std::string(1, static_cast<char>(b)), 1);
+        }
+        for (size_t k = 0; k < CPP_KEYWORDS.size(); ++k) {
+            if (total[256 + k] > 0) grupo.second.emplace(CPP_KEYWORDS[k], 1);
+        }
+    }
+    
+    if (grupos.size() > MAX_MODELOS) {
+        std::cerr << "Erro: " << grupos.size() << " grupos, mais que o máximo de " << MAX_MODELOS
+                  << " modelos! Use --modelos K." << std::endl;
+        return 1;
+    }
+    
+    std::cout << "\n=== Modelos ===" << std::endl;
+    for (const auto& grupo : grupos) {
+        int64_t ocorrencias = 0;
+        for (const auto& pair : grupo.second) ocorrencias += pair.second;
+        std::cout << std::left << std::setw(20) << grupo.first << grupo.second.size()
+                  << " símbolos, " << ocorrencias << " ocorrências" << std::endl;
+    }
+    
+    salvarPacoteFrequencias(grupos, outputFile);
     
     return 0;
 }
-
@@ -0,0 +1,103 @@
+#include "modelo.hpp"
+#include <iostream>
+#include <fstream>
+#include <iomanip>
+#include <sstream>
+
+// Gera o header com o modelo padrao (simbolos, codigos, frequencias e arvore achatada
+// como tabelas constexpr) a partir de uma tabela de frequencias
+// Roda na compilacao (ver Makefile); o compressor inclui o header gerado e
+// usa o modelo quando nao recebe tabela, sem ler arquivo nem montar arvore
+
+// Escreve o simbolo como literal C++: imprimiveis ficam como estao, o resto
+// vira escape octal de 3 digitos (nao "gruda" no caractere seguinte)
+std::string literal(const std::string& simbolo) {
+    std::ostringstream out;
+    out << "std::string_view(\"";
+    for (unsigned char c : simbolo) {
+        if (c >= 32 && c < 127 && c != '"' && c != '\\' && c != '?') {
+            out << c;
+        } else {
+            out << '\\' << std::oct << std::setw(3) << std::setfill('0') << static_cast<int>(c) << std::dec;
+        }
+    }
+    out << "\", " << simbolo.length() << ")";
+    return out.str();
+}
+
+int main(int argc, char* argv[]) {
+    if (argc < 3) {
+        std::cout << "Uso: " << argv[0] << " <tabela_frequências> <saída.hpp>" << std::endl;
+        return 1;
+    }
+    
+    std::string freqFile = argv[1];
+    std::string outputFile = argv[2];
+    
+    auto frequencies = carregarTabelaFrequencias(freqFile);
+    if (frequencies.empty()) {
+        std::cerr << "Erro: Tabela de frequências vazia ou inválida!" << std::endl;
+        return 1;
+    }
+    
+    // O modelo padrao tem que comprimir qualquer arquivo, entao todo byte
+    // que nao apareceu no corpus entra com frequencia minima
+    for (int b = 0; b < 256; ++b) {
+        frequencies.emplace(std::string(1, static_cast<char>(b)), 1);
+    }
+    
+    HuffmanTree tree;
+    tree.construirArvore(frequencies);
+    Modelo modelo;
+    if (!criarModelo(tree, frequencies, modelo)) {
+        std::cerr << "Erro: Código com mais de 64 bits no modelo padrão!" << std::endl;
+        return 1;
+    }
+    
+    std::ofstream out(outputFile);
+    if (!out.is_open()) {
+        std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
+        return 1;
+    }
+    
+    out << "// Gerado por gerador_modelo a partir de " << freqFile << " - nao edite\n"
+        << "#ifndef MODELO_PADRAO_HPP\n"
+        << "#define MODELO_PADRAO_HPP\n\n"
+        << "#include \"modelo.hpp\"\n\n"
+        << "namespace modelo_padrao {\n\n"
+        << "constexpr uint32_t ID = 0x" << std::hex << modelo.id << std::dec << "u;\n\n";
+    
+    out << "constexpr std::string_view SIMBOLOS[] = {\n";
+    for (const auto& simbolo : modelo.simbolos) {
+        out << "    " << literal(simbolo) << ",\n";
+    }
+    out << "};\n\n";
+    
+    out << "constexpr CodigoHuffman CODIGOS[] = {\n";
+    for (const auto& codigo : modelo.codigos) {
+        out << "    {0x" << std::hex << codigo.bits << std::dec << "u, "
+            << static_cast<int>(codigo.tamanho) << "},\n";
+    }
+    out << "};\n\n";
+    
+    out << "constexpr uint32_t FREQUENCIAS[] = {\n";
+    for (size_t i = 0; i < modelo.frequencias.size(); ++i) {
+        out << (i % 8 == 0 ? "    " : " ") << modelo.frequencias[i] << "u,"
+            << (i % 8 == 7 || i + 1 == modelo.frequencias.size() ? "\n" : "");
+    }
+    out << "};\n\n";
+    
+    out << "constexpr NoDecodificacao NOS[] = {\n";
+    for (const auto& no : modelo.nos) {
+        out << "    {{" << no.filho[0] << ", " << no.filho[1] << "}, " << no.simbolo << "},\n";
+    }
+    out << "};\n\n";
+    
+    out << "} // namespace modelo_padrao\n\n"
+        << "#endif // MODELO_PADRAO_HPP\n";
+    out.close();
+    
+    std::cout << "Modelo padrão gerado em " << outputFile << " (" << modelo.simbolos.size()
+              << " símbolos, id " << std::hex << modelo.id << std::dec << ")" << std::endl;
+    return 0;
+}
@@ -1,276 +1,1499 @@
 #include "huffman_tree.hpp"
+#include "modelo.hpp"
+#include "modelo_padrao.hpp"
+#include "tans.hpp"
+#include "crc32c.hpp"
+#include "fila_limitada.hpp"
+#include "arquivo_mapeado.hpp"
 #include <iostream>
 #include <fstream>
 #include <sstream>
-#include <bitset>
+#include <cstring>
+#include <cstdint>
+#include <stdexcept>
+#include <algorithm>
+#include <string_view>
+#include <thread>
 #include <filesystem>
+#include <chrono>
+#include <iomanip>
+#include <iterator>
 
 namespace fs = std::filesystem;
 
-// Le a tabela de frequencias do arquivo
-std::map<std::string, int> carregarTabelaFrequencias(const std::string& filename) {
-    std::map<std::string, int> frequencies;
-    std::ifstream file(filename);
-    
-    if (!file.is_open()) {
-        std::cerr << "Erro ao abrir arquivo de frequências: " << filename << std::endl;
-        return frequencies;
-    }
+// Formato do arquivo .huf:
+//   Cabeçalho: "HUF", versão (uint8), tamanho original (uint64),
+//     id do pacote de modelos usado (uint32) e CRC32C desses campos (uint32)
+//   Blocos em sequência até cobrir o tamanho original, cada um com
+//     tamanho original (uint32), tamanho comprimido em bytes (uint32),
+//     backend (uint8), modelo do pacote (uint8), padding do último byte
+//     (uint8), CRC32C dos campos anteriores e dos bytes comprimidos (uint32)
+//     e os bytes comprimidos
+//   Índice de pontos de controle no fim (ver escreverIndice)
+// Cada bloco cobre ~64 KiB da entrada e é codificado de forma independente,
+// o que permite decodificar só os blocos de um trecho
+const char ASSINATURA_HUF[3] = {'H', 'U', 'F'};
+const uint8_t VERSAO_HUF = 6;
+const size_t TAMANHO_BLOCO = 64 * 1024;
+const size_t TAMANHO_CABECALHO = sizeof(ASSINATURA_HUF) + 1 + 8 + 4 + 4;
+
+// Maior bloco que o compressor gera (encontrarFimBloco passa no máximo um
+// TAMANHO_BLOCO do alvo); comprimido, cada byte vira no máximo um código de
+// 64 bits, então um bloco maior que isso só pode ser arquivo corrompido
+const size_t MAX_BLOCO_ORIGINAL = 2 * TAMANHO_BLOCO;
+
+uint64_t maxBlocoComprimido(uint32_t tamanhoOriginal) {
+    return 8 * static_cast<uint64_t>(tamanhoOriginal) + 8;
+}
+
+// Backend de entropia de cada bloco: os dois usam os mesmos símbolos do modelo
+// O automático só existe na compressão: codifica com os dois e grava o menor
+const uint8_t BACKEND_HUFFMAN = 0;
+const uint8_t BACKEND_TANS = 1;
+const uint8_t BACKEND_AUTOMATICO = 0xFF;
+
+// Tamanho das leituras da entrada e dos buffers dos streams de arquivo
+const size_t TAMANHO_IO = 1024 * 1024;
+
+// Percorre os tokens do texto (igual ao frequency_counter) chamando
+// emitir(id, token), com o token apontando pro próprio texto, sem copiar
+// Palavra que está no modelo vira um token só, senão vai caractere por caractere
+// Caractere fora do modelo sai com id -1
+template <typename Emitir>
+void percorrerTokens(std::string_view text, const Modelo& modelo, Emitir emitir) {
+    size_t inicioPalavra = 0;
     
-    std::string line;
-    while (std::getline(file, line)) {
-        size_t pos = line.find('|');
-        if (pos != std::string::npos) {
-            std::string symbol = line.substr(0, pos);
-            int frequency = std::stoi(line.substr(pos + 1));
-            
-            // Desescapa caracteres especiais
-            if (symbol == "\\n") symbol = "\n";
-            else if (symbol == "\\t") symbol = "\t";
-            else if (symbol == "\\s") symbol = " ";
-            else if (symbol == "\\p") symbol = "|";
-            
-            frequencies[symbol] = frequency;
+    for (size_t i = 0; i <= text.length(); ++i) {
+        if (i < text.length() && (std::isalnum(static_cast<unsigned char>(text[i])) || text[i] == '_')) continue;
+        
+        std::string_view palavra = text.substr(inicioPalavra, i - inicioPalavra);
+        int id = palavra.length() > 1 ? modelo.obterId(palavra) : -1;
+        if (id >= 0) {
+            emitir(id, palavra);
+        } else {
+            for (size_t j = 0; j < palavra.length(); ++j) {
+                emitir(modelo.idPorByte[static_cast<unsigned char>(palavra[j])], palavra.substr(j, 1));
+            }
+        }
+        
+        if (i < text.length()) {
+            emitir(modelo.idPorByte[static_cast<unsigned char>(text[i])], text.substr(i, 1));
         }
+        inicioPalavra = i + 1;
     }
+}
+
+// Quebra o texto em ids de símbolos (-1 pros que não estão no modelo)
+std::vector<int> tokenizar(std::string_view text, const Modelo& modelo) {
+    std::vector<int> ids;
+    percorrerTokens(text, modelo, [&](int id, std::string_view) { ids.push_back(id); });
+    return ids;
+}
+
+// Escreve/le um valor binario cru (mesma ordem de bytes da maquina,
+// igual ja era feito com o tamanho original no cabecalho)
+template <typename T>
+void escreverValor(std::ostream& out, T valor) {
+    out.write(reinterpret_cast<const char*>(&valor), sizeof(valor));
+}
+
+template <typename T>
+bool lerValor(const std::vector<unsigned char>& dados, size_t& pos, T& valor) {
+    if (dados.size() - pos < sizeof(valor)) return false;
+    std::memcpy(&valor, dados.data() + pos, sizeof(valor));
+    pos += sizeof(valor);
+    return true;
+}
+
+template <typename T>
+bool lerValor(std::istream& in, T& valor) {
+    return static_cast<bool>(in.read(reinterpret_cast<char*>(&valor), sizeof(valor)));
+}
+
+// Onde termina o bloco que comeca em inicio
+// Passa de TAMANHO_BLOCO ate o proximo '\n' pra nao cortar linha no meio;
+// se a linha for gigante, corta no fim da palavra mesmo, e se a palavra
+// tambem for (nao eh palavra da tabela, entao vai caractere por caractere),
+// corta nela, pra nenhum bloco passar de MAX_BLOCO_ORIGINAL
+size_t encontrarFimBloco(std::string_view text, size_t inicio) {
+    size_t alvo = inicio + TAMANHO_BLOCO;
+    if (alvo >= text.length()) return text.length();
+    
+    size_t limite = std::min(text.length(), alvo + TAMANHO_BLOCO);
+    size_t quebra = text.find('\n', alvo);
+    if (quebra != std::string_view::npos && quebra < limite) return quebra + 1;
     
-    file.close();
-    return frequencies;
+    size_t fim = alvo;
+    while (fim < limite && (std::isalnum(static_cast<unsigned char>(text[fim])) || text[fim] == '_')) {
+        ++fim;
+    }
+    return fim;
 }
 
-// Quebra o texto em tokens (igual ao frequency_counter)
-std::vector<std::string> tokenizar(const std::string& text, const std::map<std::string, int>& frequencies) {
-    std::vector<std::string> tokens;
-    std::string palavra;
+// Primeiro símbolo da entrada que não existe no modelo: a compressão para
+// no bloco em que ele aparece, em vez de codificar o resto à toa
+struct SimboloAusente {
+    bool achou = false;
+    std::string simbolo;
+    uint64_t offset = 0;  // dentro do bloco; quem chamou soma o offset do bloco
+};
+
+void registrarSimboloAusente(std::string_view text, std::string_view token, SimboloAusente& ausente) {
+    if (ausente.achou) return;
+    ausente.achou = true;
+    ausente.simbolo = token;
+    ausente.offset = token.data() - text.data();
+}
+
+void avisarSimboloAusente(const SimboloAusente& ausente, uint64_t offsetBloco) {
+    // Byte que não é imprimível (UTF-8, binário) sai em hexa
+    unsigned char c = static_cast<unsigned char>(ausente.simbolo[0]);
+    std::ostringstream descricao;
+    if (ausente.simbolo.length() == 1 && (c < 0x20 || c >= 0x7f)) {
+        descricao << "byte 0x" << std::hex << std::setw(2) << std::setfill('0') << static_cast<int>(c);
+    } else {
+        descricao << "\"" << ausente.simbolo << "\"";
+    }
+    std::cerr << "Erro: O símbolo " << descricao.str() << " (offset " << offsetBloco + ausente.offset
+              << ") não existe no modelo! Gere a tabela com um corpus que tenha esses caracteres." << std::endl;
+}
+
+// Empacota os códigos Huffman dos ids direto em bytes (sem string de bits)
+// percorrer(escrever) chama escrever(id) pra cada símbolo, em ordem
+// Retorna a quantidade de bits validos; o resto do ultimo byte eh padding
+template <typename Percorrer>
+size_t empacotarHuffman(const Modelo& modelo, Percorrer percorrer, std::vector<unsigned char>& saida) {
+    saida.clear();
+    uint64_t acumulador = 0;  // bits ainda não escritos, alinhados à direita
+    int bitsPendentes = 0;
+    size_t totalBits = 0;
     
-    for (size_t i = 0; i < text.length(); ++i) {
-        char c = text[i];
-        
-        if (std::isalnum(c) || c == '_') {
-            palavra += c;
-        } else {
-            if (!palavra.empty()) {
-                if (frequencies.find(palavra) != frequencies.end()) {
-                    tokens.push_back(palavra);
-                } else {
-                    for (char ch : palavra) {
-                        tokens.push_back(std::string(1, ch));
-                    }
-                }
-                palavra.clear();
+    percorrer([&](int id) {
+        const CodigoHuffman& codigo = modelo.codigos[id];
+        // Descarrega bytes inteiros antes pra caber o código inteiro no acumulador
+        for (int resto = codigo.tamanho; resto > 0; ) {
+            int parte = std::min(resto, 56 - bitsPendentes);
+            uint64_t bits = (codigo.bits >> (resto - parte)) & ((uint64_t(1) << parte) - 1);
+            acumulador = (acumulador << parte) | bits;
+            bitsPendentes += parte;
+            resto -= parte;
+            while (bitsPendentes >= 8) {
+                bitsPendentes -= 8;
+                saida.push_back(static_cast<unsigned char>(acumulador >> bitsPendentes));
             }
-            
-            tokens.push_back(std::string(1, c));
         }
+        totalBits += codigo.tamanho;
+    });
+    
+    if (bitsPendentes > 0) {
+        saida.push_back(static_cast<unsigned char>(acumulador << (8 - bitsPendentes)));
     }
+    return totalBits;
+}
+
+// Codifica um bloco com Huffman tokenizando e empacotando na mesma passada
+// Símbolo fora do modelo fica de fora; o primeiro vai pra ausente
+size_t codificarBloco(std::string_view text, const Modelo& modelo, std::vector<unsigned char>& saida,
+                      SimboloAusente& ausente) {
+    saida.reserve(text.length());
+    return empacotarHuffman(modelo, [&](auto escrever) {
+        percorrerTokens(text, modelo, [&](int id, std::string_view token) {
+            if (id < 0) {
+                registrarSimboloAusente(text, token, ausente);
+            } else {
+                escrever(id);
+            }
+        });
+    }, saida);
+}
+
+// Codifica um bloco com o backend pedido e diz qual foi usado
+// O tANS precisa de todos os ids antes (codifica de trás pra frente); no
+// automático os mesmos ids passam pelos dois e fica o menor resultado
+size_t codificarBlocoCom(std::string_view text, const Modelo& modelo, uint8_t backend,
+                         std::vector<unsigned char>& saida, uint8_t& usado, SimboloAusente& ausente) {
+    usado = BACKEND_HUFFMAN;
+    if (backend == BACKEND_HUFFMAN) return codificarBloco(text, modelo, saida, ausente);
     
-    if (!palavra.empty()) {
-        if (frequencies.find(palavra) != frequencies.end()) {
-            tokens.push_back(palavra);
+    std::vector<int> ids;
+    ids.reserve(text.length() / 2);
+    percorrerTokens(text, modelo, [&](int id, std::string_view token) {
+        if (id < 0) {
+            registrarSimboloAusente(text, token, ausente);
         } else {
-            for (char ch : palavra) {
-                tokens.push_back(std::string(1, ch));
-            }
+            ids.push_back(id);
+        }
+    });
+    
+    usado = BACKEND_TANS;
+    size_t bits = codificarTans(modelo.obterTans(), ids, saida);
+    if (backend == BACKEND_AUTOMATICO) {
+        std::vector<unsigned char> huffman;
+        size_t bitsHuffman = empacotarHuffman(modelo, [&](auto escrever) {
+            for (int id : ids) escrever(id);
+        }, huffman);
+        if (huffman.size() <= saida.size()) {
+            saida.swap(huffman);
+            bits = bitsHuffman;
+            usado = BACKEND_HUFFMAN;
         }
     }
+    return bits;
+}
+
+// Escolhe o modelo do pacote que deve sair mais barato pro bloco, pelo
+// histograma de bytes (uma passada só, em vez de codificar com cada modelo)
+uint8_t escolherModelo(std::string_view text, const PacoteModelos& pacote) {
+    if (pacote.modelos.size() == 1) return 0;
     
-    return tokens;
+    uint32_t histograma[256] = {};
+    for (char c : text) histograma[static_cast<unsigned char>(c)]++;
+    
+    size_t melhor = 0;
+    double menorCusto = estimarCusto(pacote.modelos[0], histograma);
+    for (size_t i = 1; i < pacote.modelos.size(); ++i) {
+        double custo = estimarCusto(pacote.modelos[i], histograma);
+        if (custo < menorCusto) {
+            menorCusto = custo;
+            melhor = i;
+        }
+    }
+    return static_cast<uint8_t>(melhor);
 }
 
-// Funcao que comprime o arquivo
-bool comprimirArquivo(const std::string& inputFile, const std::string& outputFile, 
-                      const std::map<std::string, std::string>& codes,
-                      const std::map<std::string, int>& frequencies) {
-    // Lê o arquivo de entrada
-    std::ifstream inFile(inputFile);
-    if (!inFile.is_open()) {
-        std::cerr << "Erro ao abrir arquivo de entrada: " << inputFile << std::endl;
+// Escreve o cabeçalho do .huf com o CRC32C dos campos no fim
+void escreverCabecalho(std::ostream& out, uint64_t originalSize, uint32_t pacoteId) {
+    std::ostringstream campos;
+    campos.write(ASSINATURA_HUF, sizeof(ASSINATURA_HUF));
+    escreverValor(campos, VERSAO_HUF);
+    escreverValor(campos, originalSize);
+    escreverValor(campos, pacoteId);
+    std::string bytes = campos.str();
+    
+    out.write(bytes.data(), bytes.size());
+    escreverValor(out, calcularCrc32c(bytes.data(), bytes.size()));
+}
+
+// CRC32C do bloco: os campos do cabeçalho do bloco (na ordem em que são
+// gravados) seguidos dos bytes comprimidos
+uint32_t calcularCrcBloco(uint32_t tamanhoOriginal, uint8_t backend, uint8_t modelo, uint8_t padding,
+                          const std::vector<unsigned char>& dados) {
+    unsigned char campos[2 * sizeof(uint32_t) + 3];
+    uint32_t tamanho = static_cast<uint32_t>(dados.size());
+    std::memcpy(campos, &tamanhoOriginal, sizeof(tamanhoOriginal));
+    std::memcpy(campos + sizeof(tamanhoOriginal), &tamanho, sizeof(tamanho));
+    campos[8] = backend;
+    campos[9] = modelo;
+    campos[10] = padding;
+    return calcularCrc32c(dados.data(), dados.size(), calcularCrc32c(campos, sizeof(campos)));
+}
+
+// Ponto de controle do índice: onde cada bloco começa no texto original e no .huf
+// Como os blocos são alinhados em byte, o offset em bits é offsetArquivo * 8
+struct PontoDeControle {
+    uint64_t offsetOriginal;  // byte do texto original onde o bloco começa
+    uint64_t linha;           // linha (base 0) do primeiro byte do bloco
+    uint8_t inicioDeLinha;    // 1 se o bloco começa exatamente no início da linha
+    uint64_t offsetArquivo;   // posição do cabeçalho do bloco no .huf
+};
+
+// O índice fica no fim do arquivo, depois do último bloco:
+//   para cada bloco: offset original (uint64), linha (uint64),
+//     início de linha (uint8), offset no arquivo (uint64)
+//   número de blocos (uint32), CRC32C das entradas (uint32),
+//   offset do índice (uint64) e a assinatura "IDX"
+// Quem descomprime tudo de uma vez nem chega a ler essa parte
+const char ASSINATURA_INDICE[3] = {'I', 'D', 'X'};
+const size_t TAMANHO_ENTRADA_INDICE = 8 + 8 + 1 + 8;
+const size_t TAMANHO_RODAPE_INDICE = 4 + 4 + 8 + sizeof(ASSINATURA_INDICE);
+
+void escreverIndice(std::ofstream& out, const std::vector<PontoDeControle>& indice) {
+    uint64_t offsetIndice = out.tellp();
+    
+    std::ostringstream entradas;
+    for (const auto& ponto : indice) {
+        escreverValor(entradas, ponto.offsetOriginal);
+        escreverValor(entradas, ponto.linha);
+        escreverValor(entradas, ponto.inicioDeLinha);
+        escreverValor(entradas, ponto.offsetArquivo);
+    }
+    std::string bytes = entradas.str();
+    
+    out.write(bytes.data(), bytes.size());
+    escreverValor(out, static_cast<uint32_t>(indice.size()));
+    escreverValor(out, calcularCrc32c(bytes.data(), bytes.size()));
+    escreverValor(out, offsetIndice);
+    out.write(ASSINATURA_INDICE, sizeof(ASSINATURA_INDICE));
+}
+
+// Lê o índice do fim do arquivo; falha se não tiver índice ou se ele estiver corrompido
+bool lerIndice(std::ifstream& in, uint64_t tamanhoArquivo, std::vector<PontoDeControle>& indice) {
+    if (tamanhoArquivo < TAMANHO_RODAPE_INDICE) return false;
+    
+    std::vector<unsigned char> rodape(TAMANHO_RODAPE_INDICE);
+    in.seekg(tamanhoArquivo - TAMANHO_RODAPE_INDICE);
+    in.read(reinterpret_cast<char*>(rodape.data()), rodape.size());
+    
+    size_t pos = 0;
+    uint32_t numBlocos, crc;
+    uint64_t offsetIndice;
+    char assinatura[sizeof(ASSINATURA_INDICE)];
+    if (!in || !lerValor(rodape, pos, numBlocos) || !lerValor(rodape, pos, crc) ||
+        !lerValor(rodape, pos, offsetIndice) || !lerValor(rodape, pos, assinatura) ||
+        std::memcmp(assinatura, ASSINATURA_INDICE, sizeof(assinatura)) != 0 ||
+        offsetIndice + static_cast<uint64_t>(numBlocos) * TAMANHO_ENTRADA_INDICE + TAMANHO_RODAPE_INDICE != tamanhoArquivo) {
         return false;
     }
     
-    std::stringstream buffer;
-    buffer << inFile.rdbuf();
-    std::string content = buffer.str();
-    inFile.close();
+    std::vector<unsigned char> entradas(static_cast<size_t>(numBlocos) * TAMANHO_ENTRADA_INDICE);
+    in.seekg(offsetIndice);
+    in.read(reinterpret_cast<char*>(entradas.data()), entradas.size());
+    if (!in || calcularCrc32c(entradas.data(), entradas.size()) != crc) return false;
     
-    // Tokeniza o conteúdo
-    auto tokens = tokenizar(content, frequencies);
+    indice.clear();
+    pos = 0;
+    for (uint32_t i = 0; i < numBlocos; ++i) {
+        PontoDeControle ponto;
+        lerValor(entradas, pos, ponto.offsetOriginal);
+        lerValor(entradas, pos, ponto.linha);
+        lerValor(entradas, pos, ponto.inicioDeLinha);
+        lerValor(entradas, pos, ponto.offsetArquivo);
+        indice.push_back(ponto);
+    }
+    return true;
+}
+
+// Bloco da entrada já cortado, esperando pra ser codificado
+struct BlocoEntrada {
+    std::string texto;
+    uint64_t offsetOriginal;
+    bool inicioDeLinha;
+};
+
+// Bloco já codificado, esperando pra ser escrito
+struct BlocoCodificado {
+    uint32_t tamanhoOriginal;
+    uint8_t backend;
+    uint8_t modelo;
+    uint8_t padding;
+    uint32_t crc;
+    std::vector<unsigned char> dados;
+    PontoDeControle ponto;  // offsetArquivo é preenchido na escrita
+};
+
+// Etapa de leitura do pipeline: lê a entrada em pedaços grandes e corta os blocos
+// Mantém pelo menos 2 blocos de folga no buffer pra encontrarFimBloco achar o fim
+// da linha igual acharia com o arquivo inteiro na memória
+bool lerBlocosEntrada(std::istream& in, FilaLimitada<BlocoEntrada>& fila) {
+    std::string pendente;
+    size_t inicio = 0;
+    uint64_t offset = 0;
+    bool inicioDeLinha = true;
+    bool fimDoArquivo = false;
     
-    // Gera a sequência de bits
-    std::string bitString;
-    for (const auto& token : tokens) {
-        auto it = codes.find(token);
-        if (it != codes.end()) {
-            bitString += it->second;
-        } else {
-            std::cerr << "Aviso: Símbolo não encontrado na codificação: \"" << token << "\"" << std::endl;
-            // Usa um código de escape ou ignora
+    while (!fimDoArquivo || inicio < pendente.length()) {
+        if (!fimDoArquivo && pendente.length() - inicio <= 2 * TAMANHO_BLOCO) {
+            // Joga fora o que já foi consumido e lê direto pro fim do buffer
+            pendente.erase(0, inicio);
+            inicio = 0;
+            size_t usado = pendente.length();
+            pendente.resize(usado + TAMANHO_IO);
+            in.read(&pendente[usado], TAMANHO_IO);
+            pendente.resize(usado + in.gcount());
+            if (in.bad()) {
+                fila.fechar();
+                return false;
+            }
+            fimDoArquivo = !in;
+            continue;
         }
+        
+        size_t fim = encontrarFimBloco(pendente, inicio);
+        BlocoEntrada bloco{pendente.substr(inicio, fim - inicio), offset, inicioDeLinha};
+        inicioDeLinha = pendente[fim - 1] == '\n';
+        offset += fim - inicio;
+        inicio = fim;
+        
+        if (!fila.colocar(std::move(bloco))) break;
     }
     
-    // Calcula padding necessário para completar o último byte
-    int padding = (8 - (bitString.length() % 8)) % 8;
-    bitString += std::string(padding, '0');
+    fila.fechar();
+    return true;
+}
+
+// Etapa de escrita do pipeline: grava os blocos prontos e monta o índice
+void escreverBlocos(std::ostream& out, FilaLimitada<BlocoCodificado>& fila,
+                    std::vector<PontoDeControle>& indice) {
+    BlocoCodificado bloco;
+    while (fila.retirar(bloco)) {
+        bloco.ponto.offsetArquivo = out.tellp();
+        indice.push_back(bloco.ponto);
+        
+        escreverValor(out, bloco.tamanhoOriginal);
+        escreverValor(out, static_cast<uint32_t>(bloco.dados.size()));
+        escreverValor(out, bloco.backend);
+        escreverValor(out, bloco.modelo);
+        escreverValor(out, bloco.padding);
+        escreverValor(out, bloco.crc);
+        out.write(reinterpret_cast<const char*>(bloco.dados.data()), bloco.dados.size());
+    }
+}
+
+// Funcao que comprime o arquivo
+// Leitura, codificação e escrita rodam em etapas separadas ligadas por filas
+// de 2 posições: enquanto o bloco N é codificado, o N+1 já está sendo lido
+// e o N-1 sendo escrito
+// Com mmap os blocos são fatias do próprio arquivo mapeado e a etapa de
+// leitura nem existe (o kernel faz o readahead); sem mmap, uma thread lê a
+// entrada em pedaços grandes
+bool comprimirArquivo(const std::string& inputFile, const std::string& outputFile, 
+                      const PacoteModelos& pacote, uint8_t backend, bool usarMmap) {
+    ArquivoMapeado mapa;
+    bool mapeado = usarMmap && mapa.abrirLeitura(inputFile);
+    std::ifstream inFile;
+    if (!mapeado) {
+        inFile.open(inputFile, std::ios::binary);
+        if (!inFile.is_open()) {
+            std::cerr << "Erro ao abrir arquivo de entrada: " << inputFile << std::endl;
+            return false;
+        }
+    }
     
-    // Escreve o arquivo comprimido
-    std::ofstream outFile(outputFile, std::ios::binary);
+    // Buffer grande na saída pra juntar vários blocos em cada write
+    std::vector<char> bufferSaida(TAMANHO_IO);
+    std::ofstream outFile;
+    outFile.rdbuf()->pubsetbuf(bufferSaida.data(), bufferSaida.size());
+    outFile.open(outputFile, std::ios::binary);
     if (!outFile.is_open()) {
         std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
         return false;
     }
     
-    // Cabeçalho: tamanho original e padding
-    int originalSize = content.length();
-    outFile.write(reinterpret_cast<const char*>(&originalSize), sizeof(originalSize));
-    outFile.write(reinterpret_cast<const char*>(&padding), sizeof(padding));
+    // Cabeçalho: assinatura, versão, tamanho original e id do pacote
+    // O tamanho é conferido de novo no fim, caso o arquivo mude durante a leitura
+    // (ou nem tenha tamanho conhecido, como um pipe)
+    std::error_code erroTamanho;
+    uint64_t originalSize = mapeado ? mapa.obterTamanho() : fs::file_size(inputFile, erroTamanho);
+    if (erroTamanho) originalSize = 0;
+    escreverCabecalho(outFile, originalSize, pacote.id);
+    
+    FilaLimitada<BlocoCodificado> saida(2);
+    std::vector<PontoDeControle> indice;
+    std::thread escritor([&] { escreverBlocos(outFile, saida, indice); });
+    
+    // Cada bloco eh tokenizado e codificado sozinho, com o crc dos bytes gerados
+    uint64_t linha = 0;
+    uint64_t totalOriginal = 0;
+    size_t totalBits = 0;
+    size_t blocosTans = 0;
+    SimboloAusente ausente;
+    uint64_t offsetBlocoAusente = 0;
+    std::vector<size_t> blocosPorModelo(pacote.modelos.size(), 0);
+    // Retorna false (e para a compressão) se o bloco tem símbolo fora do modelo
+    auto codificar = [&](std::string_view texto, uint64_t offsetOriginal, bool inicioDeLinha) {
+        BlocoCodificado codificado;
+        codificado.modelo = escolherModelo(texto, pacote);
+        size_t bits = codificarBlocoCom(texto, pacote.modelos[codificado.modelo], backend,
+                                        codificado.dados, codificado.backend, ausente);
+        if (ausente.achou) {
+            offsetBlocoAusente = offsetOriginal;
+            return false;
+        }
+        blocosTans += codificado.backend == BACKEND_TANS;
+        blocosPorModelo[codificado.modelo]++;
+        codificado.tamanhoOriginal = static_cast<uint32_t>(texto.length());
+        codificado.padding = static_cast<uint8_t>(codificado.dados.size() * 8 - bits);
+        codificado.crc = calcularCrcBloco(codificado.tamanhoOriginal, codificado.backend, codificado.modelo,
+                                          codificado.padding, codificado.dados);
+        codificado.ponto = {offsetOriginal, linha, static_cast<uint8_t>(inicioDeLinha), 0};
+        
+        totalBits += bits;
+        totalOriginal += texto.length();
+        linha += std::count(texto.begin(), texto.end(), '\n');
+        saida.colocar(std::move(codificado));
+        return true;
+    };
     
-    // Converte a string de bits em bytes e escreve
-    for (size_t i = 0; i < bitString.length(); i += 8) {
-        std::bitset<8> byte(bitString.substr(i, 8));
-        unsigned char c = static_cast<unsigned char>(byte.to_ulong());
-        outFile.write(reinterpret_cast<const char*>(&c), 1);
+    bool leituraOk = true;
+    if (mapeado) {
+        std::string_view conteudo = mapa.conteudo();
+        for (size_t inicio = 0; inicio < conteudo.length(); ) {
+            size_t fim = encontrarFimBloco(conteudo, inicio);
+            if (!codificar(conteudo.substr(inicio, fim - inicio), inicio,
+                           inicio == 0 || conteudo[inicio - 1] == '\n')) break;
+            inicio = fim;
+        }
+    } else {
+        FilaLimitada<BlocoEntrada> entrada(2);
+        std::thread leitor([&] { leituraOk = lerBlocosEntrada(inFile, entrada); });
+        BlocoEntrada bloco;
+        while (entrada.retirar(bloco)) {
+            if (!codificar(bloco.texto, bloco.offsetOriginal, bloco.inicioDeLinha)) {
+                entrada.fechar();  // o leitor para no próximo bloco
+                break;
+            }
+        }
+        leitor.join();
+        inFile.close();
     }
     
+    saida.fechar();
+    escritor.join();
+    mapa.fechar();
+    
+    // Símbolo que ficou de fora sumiria na descompressão: não grava o arquivo
+    bool ok = leituraOk && !ausente.achou;
+    if (!leituraOk) {
+        std::cerr << "Erro ao ler arquivo de entrada: " << inputFile << std::endl;
+    } else if (ausente.achou) {
+        avisarSimboloAusente(ausente, offsetBlocoAusente);
+    }
+    
+    if (ok) {
+        escreverIndice(outFile, indice);
+        if (totalOriginal != originalSize) {
+            originalSize = totalOriginal;
+            outFile.seekp(0);
+            escreverCabecalho(outFile, originalSize, pacote.id);
+        }
+    }
     outFile.close();
+    if (ok && !outFile) {
+        std::cerr << "Erro ao escrever arquivo de saída: " << outputFile << std::endl;
+        ok = false;
+    }
+    
+    // Não deixa .huf pela metade pra trás
+    if (!ok) {
+        fs::remove(outputFile);
+        return false;
+    }
     
     // Estatísticas
-    int compressedSize = fs::file_size(outputFile);
-    double ratio = 1.0 - (static_cast<double>(compressedSize) / originalSize);
+    uint64_t compressedSize = fs::file_size(outputFile);
+    double ratio = originalSize > 0 ? 1.0 - (static_cast<double>(compressedSize) / originalSize) : 0.0;
     
     std::cout << "\n=== Compressão Concluída ===" << std::endl;
     std::cout << "Arquivo original: " << inputFile << " (" << originalSize << " bytes)" << std::endl;
     std::cout << "Arquivo comprimido: " << outputFile << " (" << compressedSize << " bytes)" << std::endl;
     std::cout << "Taxa de compressão: " << (ratio * 100) << "%" << std::endl;
-    std::cout << "Bits totais: " << bitString.length() - padding << std::endl;
-    std::cout << "Padding: " << padding << " bits" << std::endl;
+    std::cout << "Bits totais: " << totalBits << std::endl;
+    std::cout << "Blocos: " << indice.size() << " (CRC32C " << (crc32cTemHardware() ? "SSE4.2" : "slicing-by-8") << ")" << std::endl;
+    std::cout << "Backends: Huffman " << indice.size() - blocosTans << ", tANS " << blocosTans << std::endl;
+    if (pacote.modelos.size() > 1) {
+        std::cout << "Blocos por modelo:";
+        for (size_t i = 0; i < pacote.modelos.size(); ++i) {
+            std::cout << (i ? ", " : " ") << pacote.nomes[i] << " " << blocosPorModelo[i];
+        }
+        std::cout << std::endl;
+    }
     
     return true;
 }
 
-// Funcao que descomprime o arquivo
-bool descomprimirArquivo(const std::string& inputFile, const std::string& outputFile,
-                         std::shared_ptr<HuffmanNode> root) {
-    std::ifstream inFile(inputFile, std::ios::binary);
-    if (!inFile.is_open()) {
-        std::cerr << "Erro ao abrir arquivo comprimido: " << inputFile << std::endl;
-        return false;
+// Bloco lido do arquivo comprimido
+struct BlocoComprimido {
+    uint32_t tamanhoOriginal;
+    uint8_t backend;
+    uint8_t modelo;
+    uint8_t padding;
+    uint32_t crc;
+    bool crcOk;  // conferido na thread de leitura (sempre true com --no-verify)
+    std::vector<unsigned char> dados;
+};
+
+// Atalho da busca pra uma transição byte a byte, bem menor que a
+// TransicaoByte (a tabela inteira cabe melhor no cache): as transições que
+// não emitem nenhum símbolo do padrão só avançam offset e linha
+struct AtalhoBusca {
+    uint16_t proximo;
+    uint16_t bytes;
+    uint8_t quebras;
+    uint8_t tipo;  // ATALHO_*
+};
+
+const uint8_t ATALHO_VAZIO = 0;       // não emite nada
+const uint8_t ATALHO_FORA = 1;        // só emite símbolos fora do padrão
+const uint8_t ATALHO_COMPLETO = 2;    // precisa passar símbolo por símbolo
+
+// Chama emitir(id) a cada símbolo do bloco, com o backend gravado nele
+// No Huffman, os bytes completos passam pelas transições byte a byte; só o
+// último byte (ou tudo, se não tiver transições) é lido bit a bit
+// Com atalhos (um por transição), as que não são ATALHO_COMPLETO não emitem
+// símbolo por símbolo: pular(atalho) é chamado uma vez só
+// Falha (em vez de seguir um filho inexistente) se o bit levar pra fora da árvore
+template <typename Emitir, typename Pular>
+bool percorrerSimbolos(const BlocoComprimido& bloco, const Modelo& modelo, const AtalhoBusca* atalhos,
+                       Emitir emitir, Pular pular) {
+    size_t totalBits = bloco.dados.size() * 8 - bloco.padding;
+    if (bloco.backend == BACKEND_TANS) {
+        return decodificarTans(modelo.obterTans(), bloco.dados.data(), totalBits, emitir);
     }
     
-    // Lê o cabeçalho
-    int originalSize, padding;
-    inFile.read(reinterpret_cast<char*>(&originalSize), sizeof(originalSize));
-    inFile.read(reinterpret_cast<char*>(&padding), sizeof(padding));
+    const NoDecodificacao* nos = modelo.nos.data();
+    const auto& transicoes = modelo.obterTransicoes();
+    int atual = 0;
+    size_t i = 0;
     
-    // Lê os bytes comprimidos
-    std::vector<unsigned char> compressedData;
-    unsigned char byte;
-    while (inFile.read(reinterpret_cast<char*>(&byte), 1)) {
-        compressedData.push_back(byte);
+    if (!transicoes.empty()) {
+        const TransicaoByte* t = transicoes.data();
+        for (; i + 8 <= totalBits; i += 8) {
+            size_t indice = static_cast<size_t>(atual) * 256 + bloco.dados[i / 8];
+            if (atalhos && atalhos[indice].tipo != ATALHO_COMPLETO) {
+                pular(atalhos[indice]);
+                atual = atalhos[indice].proximo;
+                continue;
+            }
+            const TransicaoByte& passo = t[indice];
+            if (passo.invalida) return false;
+            for (int j = 0; j < passo.quantidade; ++j) {
+                emitir(passo.simbolos[j]);
+            }
+            atual = passo.proximo;
+        }
     }
-    inFile.close();
     
-    // Converte bytes em string de bits
-    std::string bitString;
-    for (unsigned char c : compressedData) {
-        std::bitset<8> bits(c);
-        bitString += bits.to_string();
+    for (; i < totalBits; ++i) {
+        int bit = (bloco.dados[i / 8] >> (7 - i % 8)) & 1;
+        
+        // Árvore de um símbolo só: todo bit é o código "0"
+        if (nos[0].simbolo >= 0) {
+            emitir(nos[0].simbolo);
+            continue;
+        }
+        
+        atual = nos[atual].filho[bit];
+        if (atual < 0) return false;
+        
+        // Se chegou em uma folha, emite o símbolo e volta pra raiz
+        if (nos[atual].simbolo >= 0) {
+            emitir(nos[atual].simbolo);
+            atual = 0;
+        }
     }
     
-    // Remove o padding
-    if (padding > 0 && bitString.length() >= static_cast<size_t>(padding)) {
-        bitString = bitString.substr(0, bitString.length() - padding);
+    // Sobrou código pela metade: tabela errada ou arquivo corrompido
+    return atual == 0;
+}
+
+template <typename Emitir>
+bool percorrerSimbolos(const BlocoComprimido& bloco, const Modelo& modelo, Emitir emitir) {
+    return percorrerSimbolos(bloco, modelo, nullptr, emitir, [](const AtalhoBusca&) {});
+}
+
+// Decodifica um bloco acrescentando o texto dos símbolos na saída
+// Falha se o texto não tiver exatamente o tamanho gravado no bloco
+bool decodificarBloco(const BlocoComprimido& bloco, const Modelo& modelo,
+                      std::string& decodedContent) {
+    const auto& simbolos = modelo.simbolos;
+    size_t inicio = decodedContent.length();
+    return percorrerSimbolos(bloco, modelo, [&](int id) { decodedContent += simbolos[id]; }) &&
+           decodedContent.length() - inicio == bloco.tamanhoOriginal;
+}
+
+// Etapa de leitura do pipeline de descompressão: lê os blocos em sequência até
+// cobrir totalOriginal bytes do texto e já confere o checksum de cada um,
+// enquanto a thread principal decodifica o anterior
+// Os campos do bloco são conferidos antes de alocar os dados: bloco maior do
+// que o compressor gera, que passa do total ou que aponta pra um modelo fora
+// do pacote conta como arquivo corrompido (mesmo com --no-verify)
+bool lerBlocosComprimidos(std::istream& in, uint64_t totalOriginal, bool verificar,
+                          size_t numModelos, FilaLimitada<BlocoComprimido>& fila) {
+    uint64_t coberto = 0;
+    bool ok = true;
+    while (coberto < totalOriginal) {
+        BlocoComprimido bloco;
+        uint32_t tamanho;
+        if (!lerValor(in, bloco.tamanhoOriginal) || !lerValor(in, tamanho) ||
+            !lerValor(in, bloco.backend) || !lerValor(in, bloco.modelo) ||
+            !lerValor(in, bloco.padding) || !lerValor(in, bloco.crc) ||
+            bloco.tamanhoOriginal == 0 || bloco.tamanhoOriginal > MAX_BLOCO_ORIGINAL ||
+            bloco.tamanhoOriginal > totalOriginal - coberto ||
+            tamanho > maxBlocoComprimido(bloco.tamanhoOriginal) ||
+            bloco.backend > BACKEND_TANS || bloco.modelo >= numModelos ||
+            bloco.padding > 7 || (tamanho == 0 && bloco.padding != 0)) {
+            ok = false;
+            break;
+        }
+        
+        bloco.dados.resize(tamanho);
+        if (!in.read(reinterpret_cast<char*>(bloco.dados.data()), tamanho)) {
+            ok = false;
+            break;
+        }
+        bloco.crcOk = !verificar || calcularCrcBloco(bloco.tamanhoOriginal, bloco.backend, bloco.modelo,
+                                                     bloco.padding, bloco.dados) == bloco.crc;
+        coberto += bloco.tamanhoOriginal;
+        
+        if (!fila.colocar(std::move(bloco))) break;
     }
     
-    // Decodifica usando a árvore
-    std::string decodedContent;
-    auto currentNode = root;
+    fila.fechar();
+    return ok;
+}
+
+// Processa os blocos com processar(bloco) na thread principal enquanto a de
+// leitura já busca e confere o próximo
+// Retorna false se a leitura ou algum processar falhar; numBlocos recebe
+// quantos blocos foram processados
+template <typename Processar>
+bool processarBlocos(std::istream& in, uint64_t totalOriginal, bool verificar, size_t numModelos,
+                     Processar processar, size_t& numBlocos) {
+    FilaLimitada<BlocoComprimido> fila(2);
+    bool leituraOk = true;
+    std::thread leitor([&] {
+        leituraOk = lerBlocosComprimidos(in, totalOriginal, verificar, numModelos, fila);
+    });
     
-    for (char bit : bitString) {
-        if (bit == '0') {
-            currentNode = currentNode->left;
-        } else {
-            currentNode = currentNode->right;
+    bool ok = true;
+    BlocoComprimido bloco;
+    numBlocos = 0;
+    while (fila.retirar(bloco)) {
+        if (!bloco.crcOk) {
+            std::cerr << "Erro: Checksum inválido no bloco " << numBlocos << "!" << std::endl;
+            ok = false;
+            break;
         }
-        
-        // Se chegou em uma folha, adiciona o símbolo
-        if (currentNode->ehFolha()) {
-            decodedContent += currentNode->symbol;
-            currentNode = root; // Volta para a raiz
+        if (!processar(bloco)) {
+            std::cerr << "Erro: Falha ao decodificar o bloco " << numBlocos
+                      << " (tabela de frequências diferente ou arquivo corrompido)!" << std::endl;
+            ok = false;
+            break;
         }
+        ++numBlocos;
     }
     
-    // Escreve o arquivo descomprimido
-    std::ofstream outFile(outputFile);
+    // Se parou no meio, fechar a fila destrava a leitura
+    fila.fechar();
+    leitor.join();
+    
+    if (ok && !leituraOk) {
+        std::cerr << "Erro: Arquivo comprimido truncado ou corrompido!" << std::endl;
+        ok = false;
+    }
+    return ok;
+}
+
+// Lê e confere o cabeçalho do arquivo .huf (assinatura, versão e CRC32C)
+bool lerCabecalho(std::istream& in, uint64_t& originalSize, uint32_t& modeloId) {
+    std::vector<unsigned char> bytes(TAMANHO_CABECALHO);
+    if (!in.read(reinterpret_cast<char*>(bytes.data()), bytes.size())) return false;
+    
+    size_t pos = 0;
+    char assinatura[sizeof(ASSINATURA_HUF)];
+    uint8_t versao = 0;
+    uint32_t crc = 0;
+    return lerValor(bytes, pos, assinatura) &&
+           std::memcmp(assinatura, ASSINATURA_HUF, sizeof(assinatura)) == 0 &&
+           lerValor(bytes, pos, versao) && versao == VERSAO_HUF &&
+           lerValor(bytes, pos, originalSize) && lerValor(bytes, pos, modeloId) &&
+           lerValor(bytes, pos, crc) && calcularCrc32c(bytes.data(), pos - sizeof(crc)) == crc;
+}
+
+bool escreverSaida(const std::string& outputFile, const std::string& conteudo) {
+    std::ofstream outFile(outputFile, std::ios::binary);
     if (!outFile.is_open()) {
         std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
         return false;
     }
     
-    outFile << decodedContent;
+    outFile << conteudo;
     outFile.close();
+    return true;
+}
+
+// Abre o arquivo comprimido com buffer grande e lê o cabeçalho
+// e confere se ele foi comprimido com o mesmo pacote de modelos
+bool abrirArquivoComprimido(const std::string& inputFile, std::ifstream& inFile,
+                            std::vector<char>& buffer, const PacoteModelos& pacote,
+                            uint64_t& originalSize) {
+    buffer.resize(TAMANHO_IO);
+    inFile.rdbuf()->pubsetbuf(buffer.data(), buffer.size());
+    inFile.open(inputFile, std::ios::binary);
+    if (!inFile.is_open()) {
+        std::cerr << "Erro ao abrir arquivo comprimido: " << inputFile << std::endl;
+        return false;
+    }
+    
+    uint32_t modeloId = 0;
+    if (!lerCabecalho(inFile, originalSize, modeloId)) {
+        std::cerr << "Erro: " << inputFile << " não é um arquivo .huf válido!" << std::endl;
+        return false;
+    }
+    if (modeloId != pacote.id) {
+        std::cerr << "Erro: " << inputFile << " foi comprimido com outro modelo!" << std::endl;
+        return false;
+    }
+    return true;
+}
+
+// Decodifica um bloco direto no destino mapeado, a partir de pos
+// Falha se o texto passar do tamanho reservado ou não tiver o tamanho gravado
+// no bloco (arquivo corrompido)
+bool decodificarBlocoEm(const BlocoComprimido& bloco, const Modelo& modelo,
+                        char* destino, size_t capacidade, size_t& pos) {
+    const auto& simbolos = modelo.simbolos;
+    size_t inicio = pos;
+    bool coube = true;
+    bool ok = percorrerSimbolos(bloco, modelo, [&](int id) {
+        const std::string& simbolo = simbolos[id];
+        if (simbolo.length() > capacidade - pos) {
+            coube = false;
+            return;
+        }
+        std::memcpy(destino + pos, simbolo.data(), simbolo.length());
+        pos += simbolo.length();
+    });
+    return ok && coube && pos - inicio == bloco.tamanhoOriginal;
+}
+
+// Funcao que descomprime o arquivo
+// Com mmap, a saída é criada já com o tamanho original e cada bloco é
+// decodificado direto nela; sem mmap, a escrita roda numa thread separada
+// Nos dois casos a leitura (com o checksum) roda em paralelo com a decodificação
+bool descomprimirArquivo(const std::string& inputFile, const std::string& outputFile,
+                         const PacoteModelos& pacote, bool verificar, bool usarMmap) {
+    std::ifstream inFile;
+    std::vector<char> bufferEntrada;
+    uint64_t originalSize = 0;
+    if (!abrirArquivoComprimido(inputFile, inFile, bufferEntrada, pacote, originalSize)) return false;
+    
+    // O tamanho já foi conferido pelo CRC do cabeçalho; se não der pra
+    // reservar o espaço da saída, escreve com streams (e um disco cheio vira
+    // erro de escrita em vez de SIGBUS)
+    ArquivoMapeado mapa;
+    bool mapeado = usarMmap && mapa.criarEscrita(outputFile, originalSize);
+    
+    std::vector<char> bufferSaida;
+    std::ofstream outFile;
+    if (!mapeado) {
+        bufferSaida.resize(TAMANHO_IO);
+        outFile.rdbuf()->pubsetbuf(bufferSaida.data(), bufferSaida.size());
+        outFile.open(outputFile, std::ios::binary);
+        if (!outFile.is_open()) {
+            std::cerr << "Erro ao criar arquivo de saída: " << outputFile << std::endl;
+            return false;
+        }
+    }
+    
+    FilaLimitada<std::string> saida(2);
+    std::thread escritor;
+    if (!mapeado) {
+        escritor = std::thread([&] {
+            std::string texto;
+            while (saida.retirar(texto)) {
+                outFile.write(texto.data(), texto.size());
+            }
+        });
+    }
+    
+    // Decodifica cada bloco com o modelo que ele usou
+    size_t totalDecodificado = 0;
+    size_t numBlocos = 0;
+    bool ok = processarBlocos(inFile, originalSize, verificar, pacote.modelos.size(),
+                              [&](const BlocoComprimido& bloco) {
+        const Modelo& modelo = pacote.modelos[bloco.modelo];
+        if (mapeado) {
+            return decodificarBlocoEm(bloco, modelo, mapa.obterDados(), mapa.obterTamanho(), totalDecodificado);
+        }
+        std::string texto;
+        texto.reserve(bloco.tamanhoOriginal);
+        if (!decodificarBloco(bloco, modelo, texto)) return false;
+        totalDecodificado += texto.length();
+        saida.colocar(std::move(texto));
+        return true;
+    }, numBlocos);
+    
+    inFile.close();
+    if (ok && totalDecodificado != originalSize) {
+        std::cerr << "Erro: Texto decodificado com " << totalDecodificado << " bytes, o cabeçalho diz "
+                  << originalSize << "!" << std::endl;
+        ok = false;
+    }
+    bool escritaOk;
+    if (mapeado) {
+        escritaOk = mapa.finalizarEscrita(totalDecodificado);
+    } else {
+        saida.fechar();
+        escritor.join();
+        outFile.close();
+        escritaOk = static_cast<bool>(outFile);
+    }
+    
+    // Não deixa saída pela metade pra trás
+    if (!ok || !escritaOk) {
+        if (ok) std::cerr << "Erro ao escrever arquivo de saída: " << outputFile << std::endl;
+        fs::remove(outputFile);
+        return false;
+    }
     
     std::cout << "\n=== Descompressão Concluída ===" << std::endl;
     std::cout << "Arquivo comprimido: " << inputFile << std::endl;
-    std::cout << "Arquivo descomprimido: " << outputFile << " (" << decodedContent.length() << " bytes)" << std::endl;
+    std::cout << "Arquivo descomprimido: " << outputFile << " (" << totalDecodificado << " bytes)" << std::endl;
+    std::cout << "Blocos: " << numBlocos << (verificar ? " (checksums conferidos)" : " (checksums ignorados)") << std::endl;
     
     return true;
 }
 
+// Padrão já tokenizado com um modelo do pacote, com a tabela do KMP
+// Os modelos de um pacote têm os mesmos símbolos (ver criarPacote), então os
+// ids são iguais em todos; só as transições (e os atalhos) mudam
+struct PadraoTokenizado {
+    std::vector<int> ids;
+    std::vector<size_t> falha;          // maior prefixo próprio de ids[0..k] que também é sufixo
+    std::vector<uint32_t> tamanhos;     // bytes de cada símbolo do modelo
+    std::vector<AtalhoBusca> atalhos;   // [transição], ver AtalhoBusca (só depois de montarAtalhos)
+    bool atalhosProntos = false;
+    int idQuebra;
+    bool possivel;                      // todos os tokens existem no modelo
+    std::string palavraCortada;         // palavra da tabela que o padrão corta no meio
+};
+
+// Procura uma palavra da tabela que o padrão começa ou termina no meio:
+// o padrão é tokenizado por caractere ali, mas no arquivo a palavra é um
+// símbolo só, então as ocorrências dentro dela nunca casam
+// ("ret" não acha nada em "return", "e;" não acha o fim de "true;")
+std::string procurarPalavraCortada(const std::string& padrao, const Modelo& modelo) {
+    auto ehDePalavra = [](unsigned char c) { return std::isalnum(c) || c == '_'; };
+    size_t fimInicio = 0;
+    while (fimInicio < padrao.length() && ehDePalavra(padrao[fimInicio])) ++fimInicio;
+    size_t inicioFim = padrao.length();
+    while (inicioFim > 0 && ehDePalavra(padrao[inicioFim - 1])) --inicioFim;
+    std::string_view inicio(padrao.data(), fimInicio);
+    std::string_view fim(padrao.data() + inicioFim, padrao.length() - inicioFim);
+    bool soPalavra = fimInicio == padrao.length();
+    
+    for (const std::string& simbolo : modelo.simbolos) {
+        if (simbolo.length() < 2) continue;
+        std::string_view palavra(simbolo);
+        if (soPalavra) {
+            // O padrão inteiro é uma palavra: só acha se for a palavra inteira
+            if (palavra.length() > padrao.length() && palavra.find(padrao) != std::string_view::npos) return simbolo;
+            continue;
+        }
+        // Fim de palavra no começo do padrão, começo de palavra no fim dele
+        if (!inicio.empty() && palavra.length() > inicio.length() &&
+            palavra.substr(palavra.length() - inicio.length()) == inicio) {
+            return simbolo;
+        }
+        if (!fim.empty() && palavra.length() > fim.length() && palavra.substr(0, fim.length()) == fim) {
+            return simbolo;
+        }
+    }
+    return "";
+}
+
+PadraoTokenizado tokenizarPadrao(const std::string& padrao, const Modelo& modelo) {
+    PadraoTokenizado p;
+    p.ids = tokenizar(padrao, modelo);
+    p.possivel = !padrao.empty() && std::find(p.ids.begin(), p.ids.end(), -1) == p.ids.end();
+    
+    // Tamanho em bytes de cada símbolo, pra saber o offset sem montar o texto
+    p.tamanhos.resize(modelo.simbolos.size());
+    for (size_t i = 0; i < modelo.simbolos.size(); ++i) p.tamanhos[i] = modelo.simbolos[i].length();
+    p.idQuebra = modelo.obterId("\n");
+    p.palavraCortada = procurarPalavraCortada(padrao, modelo);
+    
+    size_t m = p.ids.size();
+    p.falha.assign(m, 0);
+    for (size_t i = 1, k = 0; i < m; ++i) {
+        while (k > 0 && p.ids[i] != p.ids[k]) k = p.falha[k - 1];
+        if (p.ids[i] == p.ids[k]) ++k;
+        p.falha[i] = k;
+    }
+    return p;
+}
+
+// Monta os atalhos do padrão no primeiro bloco que usa o modelo (são do
+// tamanho das transições, grandes demais pra montar pra todo o pacote)
+// Transições que não emitem nenhum símbolo do padrão só avançam offset e
+// linha (e zeram o casamento parcial), sem passar símbolo por símbolo
+// Inválidas e as que passam do uint16 ficam completas (caminho normal)
+void montarAtalhos(PadraoTokenizado& p, const Modelo& modelo) {
+    std::vector<uint8_t> doPadrao(modelo.simbolos.size(), 0);
+    for (int id : p.ids) {
+        if (id >= 0) doPadrao[id] = 1;
+    }
+    const auto& transicoes = modelo.obterTransicoes();
+    p.atalhos.resize(transicoes.size());
+    for (size_t t = 0; t < transicoes.size(); ++t) {
+        const TransicaoByte& passo = transicoes[t];
+        AtalhoBusca& atalho = p.atalhos[t];
+        atalho = {passo.proximo, static_cast<uint16_t>(passo.bytes), passo.quebras,
+                  passo.quantidade > 0 ? ATALHO_FORA : ATALHO_VAZIO};
+        bool completo = passo.invalida || passo.bytes > UINT16_MAX;
+        for (int j = 0; j < passo.quantidade; ++j) completo = completo || doPadrao[passo.simbolos[j]];
+        if (completo) atalho.tipo = ATALHO_COMPLETO;
+    }
+    p.atalhosProntos = true;
+}
+
+// Procura um padrão direto no fluxo de símbolos, sem montar o texto
+// O padrão é tokenizado igual ao arquivo e vira uma sequência de ids; a busca
+// é um KMP sobre os ids decodificados, que continua de um bloco pro outro
+// (mesmo que o bloco seguinte use outro modelo: os ids são os mesmos)
+bool buscarPadrao(const std::string& inputFile, const std::string& padrao, const PacoteModelos& pacote,
+                  bool verificar) {
+    std::ifstream inFile;
+    std::vector<char> bufferEntrada;
+    uint64_t originalSize = 0;
+    if (!abrirArquivoComprimido(inputFile, inFile, bufferEntrada, pacote, originalSize)) return false;
+    
+    // Os modelos têm os mesmos símbolos, então tokenizam o padrão igual
+    // Um token fora da tabela nunca aparece no arquivo: zero ocorrências
+    std::vector<PadraoTokenizado> padroes;
+    for (const auto& modelo : pacote.modelos) padroes.push_back(tokenizarPadrao(padrao, modelo));
+    const PadraoTokenizado& tokenizado = padroes[0];
+    uint64_t quebrasNoPadrao = std::count(padrao.begin(), padrao.end(), '\n');
+    if (!tokenizado.palavraCortada.empty()) {
+        std::cerr << "Aviso: O padrão começa ou termina no meio da palavra \"" << tokenizado.palavraCortada
+                  << "\" da tabela; ocorrências dentro dela não são contadas!" << std::endl;
+    }
+    
+    std::vector<std::pair<uint64_t, uint64_t>> ocorrencias; // (offset, linha base 1)
+    uint64_t offset = 0, linha = 0;
+    size_t k = 0;
+    const PadraoTokenizado* p = &padroes[0];
+    auto emitir = [&](int id) {
+        offset += p->tamanhos[id];
+        if (id == p->idQuebra) ++linha;
+        while (k > 0 && p->ids[k] != id) k = p->falha[k - 1];
+        if (p->ids[k] == id && ++k == p->ids.size()) {
+            ocorrencias.emplace_back(offset - padrao.length(), linha - quebrasNoPadrao + 1);
+            k = p->falha[k - 1];
+        }
+    };
+    
+    // Transição sem símbolo do padrão: um símbolo fora do padrão sempre leva
+    // o KMP de volta pro início, então basta somar bytes e quebras
+    auto pular = [&](const AtalhoBusca& atalho) {
+        offset += atalho.bytes;
+        linha += atalho.quebras;
+        if (atalho.tipo == ATALHO_FORA) k = 0;
+    };
+    
+    size_t numBlocos = 0;
+    if (tokenizado.possivel) {
+        bool ok = processarBlocos(inFile, originalSize, verificar, pacote.modelos.size(),
+                                  [&](const BlocoComprimido& bloco) {
+            p = &padroes[bloco.modelo];
+            if (!p->atalhosProntos) montarAtalhos(padroes[bloco.modelo], pacote.modelos[bloco.modelo]);
+            uint64_t inicio = offset;
+            return percorrerSimbolos(bloco, pacote.modelos[bloco.modelo], p->atalhos.data(), emitir, pular) &&
+                   offset - inicio == bloco.tamanhoOriginal;
+        }, numBlocos);
+        if (!ok) return false;
+    }
+    
+    std::cout << "\n=== Busca Concluída ===" << std::endl;
+    std::cout << "Arquivo comprimido: " << inputFile << std::endl;
+    std::cout << "Padrão: \"" << padrao << "\" ("
+              << (tokenizado.possivel ? std::to_string(tokenizado.ids.size()) + " símbolos"
+                                      : std::string("tem caractere fora do modelo"))
+              << ")" << std::endl;
+    for (const auto& ocorrencia : ocorrencias) {
+        std::cout << "  offset " << ocorrencia.first << " (linha " << ocorrencia.second << ")" << std::endl;
+    }
+    std::cout << "Ocorrências: " << ocorrencias.size() << std::endl;
+    
+    return true;
+}
+
+// Trecho pedido na extração parcial: por bytes (--range) ou por linhas (--lines)
+struct Trecho {
+    bool porLinhas = false;
+    uint64_t inicio = 0;  // byte inicial ou primeira linha (base 1)
+    uint64_t fim = 0;     // byte final (exclusivo) ou última linha (inclusive)
+};
+
+// Extrai só um trecho: usa o índice pra achar o ponto de controle mais próximo
+// e decodifica apenas os blocos que cobrem o trecho
+bool extrairTrecho(const std::string& inputFile, const std::string& outputFile,
+                   const PacoteModelos& pacote, bool verificar, const Trecho& trecho) {
+    std::ifstream inFile;
+    std::vector<char> bufferEntrada;
+    uint64_t originalSize = 0;
+    if (!abrirArquivoComprimido(inputFile, inFile, bufferEntrada, pacote, originalSize)) return false;
+    
+    uint64_t tamanhoArquivo = fs::file_size(inputFile);
+    std::vector<PontoDeControle> indice;
+    if (!lerIndice(inFile, tamanhoArquivo, indice)) {
+        std::cerr << "Erro: " << inputFile << " não tem índice de pontos de controle válido!" << std::endl;
+        return false;
+    }
+    
+    // Primeiro bloco: o último ponto de controle que começa antes do trecho
+    // (pra linhas, o bloco precisa começar no início da linha pedida ou antes dela)
+    auto comecaDepois = [&](const PontoDeControle& ponto) {
+        if (!trecho.porLinhas) return ponto.offsetOriginal > trecho.inicio;
+        uint64_t linhaPedida = trecho.inicio - 1;
+        return ponto.linha > linhaPedida || (ponto.linha == linhaPedida && !ponto.inicioDeLinha);
+    };
+    size_t primeiro = 0;
+    while (primeiro + 1 < indice.size() && !comecaDepois(indice[primeiro + 1])) ++primeiro;
+    
+    // Último bloco: para antes do primeiro ponto que já começa depois do fim do trecho
+    size_t ultimo = primeiro;
+    while (ultimo + 1 < indice.size() &&
+           (trecho.porLinhas ? indice[ultimo + 1].linha < trecho.fim
+                             : indice[ultimo + 1].offsetOriginal < trecho.fim)) {
+        ++ultimo;
+    }
+    
+    std::string decodedContent;
+    size_t numBlocos = 0;
+    if (!indice.empty()) {
+        uint64_t fimOriginal = ultimo + 1 < indice.size() ? indice[ultimo + 1].offsetOriginal : originalSize;
+        if (fimOriginal < indice[primeiro].offsetOriginal) {
+            std::cerr << "Erro: Índice de pontos de controle inconsistente!" << std::endl;
+            return false;
+        }
+        
+        // Pula direto pro bloco do ponto de controle e lê só os blocos escolhidos
+        inFile.seekg(indice[primeiro].offsetArquivo);
+        bool ok = processarBlocos(inFile, fimOriginal - indice[primeiro].offsetOriginal, verificar,
+                                  pacote.modelos.size(), [&](const BlocoComprimido& bloco) {
+                                      return decodificarBloco(bloco, pacote.modelos[bloco.modelo], decodedContent);
+                                  }, numBlocos);
+        if (!ok) return false;
+    }
+    inFile.close();
+    
+    // Recorta o trecho dentro do que foi decodificado
+    std::string resultado;
+    if (!trecho.porLinhas) {
+        uint64_t base = indice.empty() ? 0 : indice[primeiro].offsetOriginal;
+        if (trecho.inicio < base + decodedContent.length()) {
+            resultado = decodedContent.substr(trecho.inicio - base, trecho.fim - trecho.inicio);
+        }
+    } else if (!indice.empty()) {
+        // Pula as linhas que vêm antes da pedida dentro do primeiro bloco
+        uint64_t linha = indice[primeiro].linha;
+        size_t inicio = 0;
+        if (!indice[primeiro].inicioDeLinha) {
+            inicio = decodedContent.find('\n');
+            inicio = inicio == std::string::npos ? decodedContent.length() : inicio + 1;
+            ++linha;
+        }
+        while (linha + 1 < trecho.inicio && inicio < decodedContent.length()) {
+            size_t quebra = decodedContent.find('\n', inicio);
+            inicio = quebra == std::string::npos ? decodedContent.length() : quebra + 1;
+            ++linha;
+        }
+        size_t fim = inicio;
+        while (linha < trecho.fim && fim < decodedContent.length()) {
+            size_t quebra = decodedContent.find('\n', fim);
+            fim = quebra == std::string::npos ? decodedContent.length() : quebra + 1;
+            ++linha;
+        }
+        resultado = decodedContent.substr(inicio, fim - inicio);
+    }
+    
+    if (!escreverSaida(outputFile, resultado)) return false;
+    
+    std::cout << "\n=== Extração Concluída ===" << std::endl;
+    std::cout << "Arquivo comprimido: " << inputFile << std::endl;
+    std::cout << "Trecho extraído: " << outputFile << " (" << resultado.length() << " bytes)" << std::endl;
+    std::cout << "Blocos decodificados: " << numBlocos << " de " << indice.size() << std::endl;
+    
+    return true;
+}
+
+// Mede taxa e velocidade de cada backend na mesma entrada, sem gravar nada
+// Os blocos são cortados igual à compressão e o tempo conta só codificação
+// e decodificação em memória (o melhor de algumas rodadas)
+bool compararBackends(const std::string& inputFile, const PacoteModelos& pacote) {
+    ArquivoMapeado mapa;
+    std::string copia;
+    std::string_view conteudo;
+    if (mapa.abrirLeitura(inputFile)) {
+        conteudo = mapa.conteudo();
+    } else {
+        std::ifstream inFile(inputFile, std::ios::binary);
+        if (!inFile.is_open()) {
+            std::cerr << "Erro ao abrir arquivo de entrada: " << inputFile << std::endl;
+            return false;
+        }
+        copia.assign(std::istreambuf_iterator<char>(inFile), std::istreambuf_iterator<char>());
+        conteudo = copia;
+    }
+    
+    std::vector<std::string_view> blocos;
+    for (size_t inicio = 0; inicio < conteudo.length(); ) {
+        size_t fim = encontrarFimBloco(conteudo, inicio);
+        blocos.push_back(conteudo.substr(inicio, fim - inicio));
+        inicio = fim;
+    }
+    
+    // Cabeçalho de cada bloco: tamanhos, backend, modelo, padding e crc
+    const size_t CABECALHO_BLOCO = 2 * sizeof(uint32_t) + 3 * sizeof(uint8_t) + sizeof(uint32_t);
+    const int RODADAS = 3;
+    double megabytes = conteudo.length() / (1024.0 * 1024.0);
+    auto segundosDesde = [](std::chrono::steady_clock::time_point inicio) {
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - inicio).count();
+    };
+    
+    std::cout << "\n=== Comparação de Backends ===" << std::endl;
+    std::cout << "Arquivo: " << inputFile << " (" << conteudo.length() << " bytes, "
+              << blocos.size() << " blocos)" << std::endl;
+    std::cout << "\nBackend     Bytes       Taxa (%)  Comp. MB/s  Descomp. MB/s" << std::endl;
+    
+    const std::pair<const char*, uint8_t> backends[] = {
+        {"huffman", BACKEND_HUFFMAN}, {"tans", BACKEND_TANS}, {"auto", BACKEND_AUTOMATICO}};
+    bool tudoOk = true;
+    for (const auto& [nome, backend] : backends) {
+        std::vector<BlocoComprimido> comprimidos(blocos.size());
+        double tempoCodificacao = 1e30, tempoDecodificacao = 1e30;
+        size_t tamanho = 0;
+        SimboloAusente ausente;
+        
+        for (int rodada = 0; rodada < RODADAS; ++rodada) {
+            auto inicio = std::chrono::steady_clock::now();
+            tamanho = 0;
+            for (size_t i = 0; i < blocos.size(); ++i) {
+                BlocoComprimido& bloco = comprimidos[i];
+                bloco.modelo = escolherModelo(blocos[i], pacote);
+                bloco.tamanhoOriginal = static_cast<uint32_t>(blocos[i].length());
+                size_t bits = codificarBlocoCom(blocos[i], pacote.modelos[bloco.modelo], backend,
+                                                bloco.dados, bloco.backend, ausente);
+                if (ausente.achou) {
+                    avisarSimboloAusente(ausente, blocos[i].data() - conteudo.data());
+                    return false;
+                }
+                bloco.padding = static_cast<uint8_t>(bloco.dados.size() * 8 - bits);
+                tamanho += CABECALHO_BLOCO + bloco.dados.size();
+            }
+            tempoCodificacao = std::min(tempoCodificacao, segundosDesde(inicio));
+        }
+        
+        // Decodifica num buffer do tamanho original, como a descompressão com mmap
+        std::string saida(conteudo.length(), '\0');
+        bool ok = true;
+        for (int rodada = 0; rodada < RODADAS; ++rodada) {
+            auto inicio = std::chrono::steady_clock::now();
+            size_t pos = 0;
+            for (const auto& bloco : comprimidos) {
+                ok = decodificarBlocoEm(bloco, pacote.modelos[bloco.modelo], &saida[0], saida.length(), pos) && ok;
+            }
+            tempoDecodificacao = std::min(tempoDecodificacao, segundosDesde(inicio));
+            ok = ok && pos == saida.length();
+        }
+        ok = ok && saida == conteudo;
+        tudoOk = tudoOk && ok;
+        
+        double taxa = conteudo.empty() ? 0.0 : 1.0 - static_cast<double>(tamanho) / conteudo.length();
+        std::cout << std::left << std::setw(12) << nome << std::setw(12) << tamanho
+                  << std::fixed << std::setprecision(2) << std::setw(10) << taxa * 100
+                  << std::setw(12) << megabytes / tempoCodificacao
+                  << megabytes / tempoDecodificacao
+                  << (ok ? "" : "  ✗ texto diferente") << std::endl;
+        std::cout.unsetf(std::ios::floatfield | std::ios::adjustfield);
+    }
+    
+    return tudoOk;
+}
+
+// Lê "inicio:tamanho" (--range) ou "a-b" (--lines) em um Trecho
+bool lerTrecho(const std::string& texto, char separador, bool porLinhas, Trecho& trecho) {
+    size_t pos = texto.find(separador);
+    if (pos == std::string::npos || pos == 0 || pos + 1 == texto.length()) return false;
+    
+    std::string a = texto.substr(0, pos), b = texto.substr(pos + 1);
+    auto ehNumero = [](const std::string& s) {
+        return std::all_of(s.begin(), s.end(), [](unsigned char c) { return std::isdigit(c); });
+    };
+    if (!ehNumero(a) || !ehNumero(b)) return false;
+    
+    uint64_t valorA, valorB;
+    try {
+        valorA = std::stoull(a);
+        valorB = std::stoull(b);
+    } catch (const std::out_of_range&) {
+        return false;
+    }
+    
+    trecho.porLinhas = porLinhas;
+    trecho.inicio = valorA;
+    // Tamanho que passa do fim do espaço de offsets vai até o fim do arquivo
+    trecho.fim = porLinhas ? valorB : trecho.inicio + std::min(valorB, UINT64_MAX - trecho.inicio);
+    return !porLinhas || (trecho.inicio >= 1 && trecho.inicio <= trecho.fim);
+}
+
+// Monta o modelo padrão a partir das tabelas constexpr geradas na compilação
+// As transições byte a byte ficam pra quando o modelo for usado (gerar como
+// constexpr deixaria o binário com alguns MB a mais)
+PacoteModelos criarModeloPadrao() {
+    Modelo modelo;
+    modelo.simbolos.assign(std::begin(modelo_padrao::SIMBOLOS), std::end(modelo_padrao::SIMBOLOS));
+    modelo.codigos.assign(std::begin(modelo_padrao::CODIGOS), std::end(modelo_padrao::CODIGOS));
+    modelo.frequencias.assign(std::begin(modelo_padrao::FREQUENCIAS), std::end(modelo_padrao::FREQUENCIAS));
+    modelo.nos.assign(std::begin(modelo_padrao::NOS), std::end(modelo_padrao::NOS));
+    completarModelo(modelo);
+    modelo.id = modelo_padrao::ID;
+    
+    PacoteModelos pacote;
+    pacote.nomes.push_back("padrão");
+    pacote.modelos.push_back(std::move(modelo));
+    pacote.id = calcularIdPacote(pacote);
+    return pacote;
+}
+
 void imprimirUso(const char* programName) {
-    std::cout << "Uso: " << programName << " <modo> <arquivo_entrada> <arquivo_saída> <tabela_frequências>" << std::endl;
+    std::cout << "Uso: " << programName << " <modo> <arquivo_entrada> <arquivo_saída> [tabela_frequências] [opções]" << std::endl;
+    std::cout << "\nSem tabela, usa o modelo padrão embutido no programa. A tabela pode ser um" << std::endl;
+    std::cout << "pacote com vários modelos (frequency_counter --modelos); cada bloco usa o mais barato." << std::endl;
     std::cout << "\nModos:" << std::endl;
     std::cout << "  -c, --compress     Comprimir arquivo" << std::endl;
     std::cout << "  -d, --decompress   Descomprimir arquivo" << std::endl;
+    std::cout << "  -g, --grep         Procurar um padrão sem descomprimir (" << programName
+              << " -g <padrão> <arquivo.huf> [tabela_frequências])" << std::endl;
+    std::cout << "  -b, --bench        Comparar taxa e MB/s dos backends (" << programName
+              << " -b <arquivo> [tabela_frequências])" << std::endl;
+    std::cout << "\nOpções:" << std::endl;
+    std::cout << "  --no-verify        Não confere os checksums dos blocos (dados confiáveis)" << std::endl;
+    std::cout << "  --no-mmap          Lê e escreve com streams em vez de mapear os arquivos" << std::endl;
+    std::cout << "  --range ini:tam    Com -d, extrai só tam bytes a partir do byte ini" << std::endl;
+    std::cout << "  --lines a-b        Com -d, extrai só as linhas a até b (base 1)" << std::endl;
+    std::cout << "  --backend nome     Com -c, codifica os blocos com huffman (padrão), tans ou" << std::endl;
+    std::cout << "                     auto (o menor dos dois em cada bloco)" << std::endl;
     std::cout << "\nExemplos:" << std::endl;
     std::cout << "  Comprimir:   " << programName << " -c exemplo.cpp exemplo.huf frequencias.txt" << std::endl;
+    std::cout << "  Modelo padrão: " << programName << " -c exemplo.cpp exemplo.huf" << std::endl;
     std::cout << "  Descomprimir: " << programName << " -d exemplo.huf exemplo_restaurado.cpp frequencias.txt" << std::endl;
+    std::cout << "  Extrair:      " << programName << " -d exemplo.huf trecho.cpp frequencias.txt --lines 10-20" << std::endl;
+    std::cout << "  Buscar:       " << programName << " -g \"virtual void\" exemplo.huf frequencias.txt" << std::endl;
 }
 
 int main(int argc, char* argv[]) {
-    if (argc < 5) {
+    std::string mode = argc > 1 ? argv[1] : "";
+    // No benchmark só tem o arquivo de entrada
+    bool bench = mode == "-b" || mode == "--bench";
+    if (argc < (bench ? 3 : 4)) {
         imprimirUso(argv[0]);
         return 1;
     }
     
-    std::string mode = argv[1];
-    std::string inputFile = argv[2];
-    std::string outputFile = argv[3];
-    std::string freqFile = argv[4];
+    // Na busca o segundo argumento é o padrão e não tem arquivo de saída
+    bool busca = mode == "-g" || mode == "--grep";
+    std::string padrao = busca ? argv[2] : "";
+    std::string inputFile = busca ? argv[3] : argv[2];
+    std::string outputFile = busca || bench ? "" : argv[3];
+    if (busca && padrao.empty()) {
+        std::cerr << "Erro: O padrão da busca não pode ser vazio!" << std::endl;
+        return 1;
+    }
+    // A tabela é opcional: sem ela (ou se o próximo argumento já é uma opção)
+    // usa o modelo padrão
+    int proximo = bench ? 3 : 4;
+    std::string freqFile;
+    if (argc > proximo && std::string(argv[proximo]).rfind("--", 0) != 0) {
+        freqFile = argv[proximo++];
+    }
+    uint8_t backend = BACKEND_HUFFMAN;
+    bool verificar = true;
+    bool usarMmap = true;
+    bool parcial = false;
+    Trecho trecho;
     
-    std::cout << "=== Compressor/Descompressor de Huffman ===" << std::endl;
+    for (int i = proximo; i < argc; ++i) {
+        std::string opcao = argv[i];
+        if (opcao == "--no-verify") {
+            verificar = false;
+        } else if (opcao == "--no-mmap") {
+            usarMmap = false;
+        } else if ((opcao == "--range" || opcao == "--lines") && i + 1 < argc) {
+            bool porLinhas = opcao == "--lines";
+            if (!lerTrecho(argv[++i], porLinhas ? '-' : ':', porLinhas, trecho)) {
+                std::cerr << "Erro: Trecho inválido para " << opcao << ": " << argv[i] << std::endl;
+                return 1;
+            }
+            parcial = true;
+        } else if (opcao == "--backend" && i + 1 < argc) {
+            std::string nome = argv[++i];
+            if (nome == "huffman") backend = BACKEND_HUFFMAN;
+            else if (nome == "tans") backend = BACKEND_TANS;
+            else if (nome == "auto") backend = BACKEND_AUTOMATICO;
+            else {
+                std::cerr << "Erro: Backend inválido: " << nome << std::endl;
+                return 1;
+            }
+        } else {
+            std::cerr << "Erro: Opção inválida: " << opcao << std::endl;
+            imprimirUso(argv[0]);
+            return 1;
+        }
+    }
     
-    // Carrega a tabela de frequências
-    std::cout << "Carregando tabela de frequências..." << std::endl;
-    auto frequencies = carregarTabelaFrequencias(freqFile);
+    std::cout << "=== Compressor/Descompressor de Huffman ===" << std::endl;
     
-    if (frequencies.empty()) {
-        std::cerr << "Erro: Tabela de frequências vazia ou inválida!" << std::endl;
-        return 1;
+    PacoteModelos pacote;
+    if (freqFile.empty()) {
+        std::cout << "Usando modelo padrão..." << std::endl;
+        pacote = criarModeloPadrao();
+    } else {
+        // Carrega a tabela de frequências (ou o pacote com uma por modelo)
+        std::cout << "Carregando tabela de frequências..." << std::endl;
+        auto tabelas = carregarPacoteFrequencias(freqFile);
+        
+        if (tabelas.empty()) {
+            std::cerr << "Erro: Tabela de frequências vazia ou inválida!" << std::endl;
+            return 1;
+        }
+        if (tabelas.size() > MAX_MODELOS) {
+            std::cerr << "Erro: Pacote com mais de " << MAX_MODELOS << " modelos!" << std::endl;
+            return 1;
+        }
+        
+        for (const auto& tabela : tabelas) {
+            std::cout << "Símbolos carregados: " << tabela.second.size()
+                      << (tabela.first.empty() ? "" : " (" + tabela.first + ")") << std::endl;
+        }
+        
+        // Constrói uma árvore de Huffman por modelo
+        std::cout << "Construindo árvore de Huffman..." << std::endl;
+        if (!criarPacote(tabelas, pacote)) {
+            std::cerr << "Erro: Árvore de Huffman inválida!" << std::endl;
+            return 1;
+        }
     }
     
-    std::cout << "Símbolos carregados: " << frequencies.size() << std::endl;
-    
-    // Constrói a árvore de Huffman
-    std::cout << "Construindo árvore de Huffman..." << std::endl;
-    HuffmanTree tree;
-    tree.construirArvore(frequencies);
+    for (const auto& modelo : pacote.modelos) {
+        if (backend != BACKEND_HUFFMAN && !cabeNoTans(modelo.simbolos.size())) {
+            std::cerr << "Erro: Modelo com símbolos demais para o tANS!" << std::endl;
+            return 1;
+        }
+    }
     
     if (mode == "-c" || mode == "--compress") {
         // Modo compressão
-        auto codes = tree.obterCodigos();
-        std::cout << "Códigos gerados: " << codes.size() << std::endl;
+        if (parcial) {
+            std::cerr << "Erro: --range e --lines só valem para descompressão!" << std::endl;
+            return 1;
+        }
+        for (const auto& modelo : pacote.modelos) {
+            std::cout << "Códigos gerados: " << modelo.codigos.size() << std::endl;
+        }
         
-        return comprimirArquivo(inputFile, outputFile, codes, frequencies) ? 0 : 1;
+        return comprimirArquivo(inputFile, outputFile, pacote, backend, usarMmap) ? 0 : 1;
         
     } else if (mode == "-d" || mode == "--decompress") {
         // Modo descompressão
-        auto root = tree.obterRaiz();
-        if (!root) {
-            std::cerr << "Erro: Árvore de Huffman inválida!" << std::endl;
+        if (parcial) {
+            return extrairTrecho(inputFile, outputFile, pacote, verificar, trecho) ? 0 : 1;
+        }
+        return descomprimirArquivo(inputFile, outputFile, pacote, verificar, usarMmap) ? 0 : 1;
+        
+    } else if (busca) {
+        // Modo busca
+        if (parcial) {
+            std::cerr << "Erro: --range e --lines só valem para descompressão!" << std::endl;
             return 1;
         }
+        return buscarPadrao(inputFile, padrao, pacote, verificar) ? 0 : 1;
         
-        return descomprimirArquivo(inputFile, outputFile, root) ? 0 : 1;
+    } else if (bench) {
+        // Modo benchmark
+        return compararBackends(inputFile, pacote) ? 0 : 1;
         
     } else {
         std::cerr << "Erro: Modo inválido: " << mode << std::endl;
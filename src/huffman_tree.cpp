@@ -1,6 +1,7 @@
 #include "huffman_tree.hpp"
 #include <iostream>
 #include <iomanip>
+#include <algorithm>
 
 void HuffmanTree::construirArvore(const std::map<std::string, int>& frequencies) {
     if (frequencies.empty()) {
@@ -13,9 +14,14 @@ void HuffmanTree::construirArvore(const std::map<std::string, int>& frequencies)
                        std::vector<std::shared_ptr<HuffmanNode>>, 
                        NodeComparator> heap;
     
-    // Coloca todos os simbolos no heap
+    simbolos.clear();
+    int proximaOrdem = 0;
+    
+    // Coloca todos os simbolos no heap (em ordem de simbolo, pela do map)
     for (const auto& pair : frequencies) {
-        auto no_atual = std::make_shared<HuffmanNode>(pair.first, pair.second);
+        simbolos.push_back(pair.first);
+
+        auto no_atual = std::make_shared<HuffmanNode>(pair.first, pair.second, proximaOrdem++);
         heap.push(no_atual);
     }
     
@@ -29,7 +35,7 @@ void HuffmanTree::construirArvore(const std::map<std::string, int>& frequencies)
         heap.pop();
         
         // Cria no pai com soma das frequencias
-        auto pai = std::make_shared<HuffmanNode>("", esquerda->frequency + direita->frequency);
+        auto pai = std::make_shared<HuffmanNode>("", esquerda->frequency + direita->frequency, proximaOrdem++);
         pai->left = esquerda;
         pai->right = direita;
         
@@ -40,6 +46,9 @@ void HuffmanTree::construirArvore(const std::map<std::string, int>& frequencies)
     
     codigos.clear();
     gerarCodigos(raiz, "");
+    
+    tabelaDecodificacao.clear();
+    achatarArvore(raiz);
 }
 
 void HuffmanTree::gerarCodigos(std::shared_ptr<HuffmanNode> node, const std::string& code) {
@@ -55,6 +64,64 @@ void HuffmanTree::gerarCodigos(std::shared_ptr<HuffmanNode> node, const std::str
     gerarCodigos(node->right, code + "1");
 }
 
+int HuffmanTree::achatarArvore(const std::shared_ptr<HuffmanNode>& node) {
+    int indice = static_cast<int>(tabelaDecodificacao.size());
+    tabelaDecodificacao.push_back({{-1, -1}, -1});
+    
+    if (node->ehFolha()) {
+        // simbolos esta em ordem crescente (veio do std::map)
+        auto it = std::lower_bound(simbolos.begin(), simbolos.end(), node->symbol);
+        tabelaDecodificacao[indice].simbolo = static_cast<int>(it - simbolos.begin());
+        return indice;
+    }
+    
+    // Nao da pra guardar referencia pro no: o vetor cresce na recursao
+    int esquerda = node->left ? achatarArvore(node->left) : -1;
+    int direita = node->right ? achatarArvore(node->right) : -1;
+    tabelaDecodificacao[indice].filho[0] = esquerda;
+    tabelaDecodificacao[indice].filho[1] = direita;
+    return indice;
+}
+
+std::vector<TransicaoByte> construirTransicoes(const std::vector<NoDecodificacao>& nos,
+                                               const std::vector<std::string>& simbolos) {
+    std::vector<TransicaoByte> transicoes;
+    if (nos.size() < 2 || nos.size() > UINT16_MAX) return transicoes;
+    
+    transicoes.resize(nos.size() * 256);
+    for (size_t no = 0; no < nos.size(); ++no) {
+        // Folhas nunca sao ponto de partida, a leitura sempre volta pra raiz
+        if (nos[no].simbolo >= 0) continue;
+        
+        for (int byte = 0; byte < 256; ++byte) {
+            TransicaoByte& t = transicoes[no * 256 + byte];
+            t.quantidade = 0;
+            t.invalida = false;
+            t.bytes = 0;
+            t.quebras = 0;
+            int atual = static_cast<int>(no);
+            
+            for (int bit = 7; bit >= 0; --bit) {
+                atual = nos[atual].filho[(byte >> bit) & 1];
+                if (atual < 0) {
+                    t.invalida = true;
+                    atual = 0;
+                    break;
+                }
+                if (nos[atual].simbolo >= 0) {
+                    const std::string& simbolo = simbolos[nos[atual].simbolo];
+                    t.simbolos[t.quantidade++] = static_cast<uint16_t>(nos[atual].simbolo);
+                    t.bytes += static_cast<uint32_t>(simbolo.length());
+                    t.quebras += simbolo == "\n";
+                    atual = 0;
+                }
+            }
+            t.proximo = static_cast<uint16_t>(atual);
+        }
+    }
+    return transicoes;
+}
+
 void HuffmanTree::imprimirArvore(std::shared_ptr<HuffmanNode> node, int depth) const {
     if (!node) {
         node = raiz;
@@ -6,39 +6,75 @@
 #include <memory>
 #include <queue>
 #include <vector>
+#include <cstdint>
 
 // Estrutura do no da arvore
 struct HuffmanNode {
     std::string symbol;      
     int frequency;           
+    int ordem;               // ordem de criacao, desempata frequencias iguais
     std::shared_ptr<HuffmanNode> left;
     std::shared_ptr<HuffmanNode> right;
     
-    HuffmanNode(const std::string& sym, int freq)
-        : symbol(sym), frequency(freq), left(nullptr), right(nullptr) {}
+    HuffmanNode(const std::string& sym, int freq, int ordem)
+        : symbol(sym), frequency(freq), ordem(ordem), left(nullptr), right(nullptr) {}
     
     bool ehFolha() const {
         return left == nullptr && right == nullptr;
     }
 };
 
+// No da arvore achatada num vetor, usada pra decodificar sem ponteiros
+// filho[b] eh o indice do no seguido pelo bit b (-1 se nao existe)
+// Nas folhas simbolo eh o id do simbolo, nos nos internos eh -1
+struct NoDecodificacao {
+    int filho[2];
+    int simbolo;
+};
+
+// Decodificacao de um byte inteiro de uma vez: partindo de um no e lendo
+// os 8 bits, quais simbolos saem e em qual no termina
+struct TransicaoByte {
+    uint16_t simbolos[8];
+    uint8_t quantidade;
+    bool invalida;     // algum bit levou pra um filho que nao existe
+    uint16_t proximo;  // no onde a leitura parou (0 = raiz)
+    uint32_t bytes;    // bytes de texto dos simbolos emitidos
+    uint8_t quebras;   // quantos deles sao '\n'
+};
+
 // Comparador pro heap - pega sempre o menor
+// No empate vai o criado primeiro: sem isso a ordem dependeria do heap de
+// cada biblioteca padrao, e os codigos (e o id do modelo) mudariam entre builds
 struct NodeComparator {
     bool operator()(const std::shared_ptr<HuffmanNode>& a, 
                    const std::shared_ptr<HuffmanNode>& b) const {
-        return a->frequency > b->frequency; 
+        if (a->frequency != b->frequency) return a->frequency > b->frequency;
+        return a->ordem > b->ordem;
     }
 };
 
+// Monta as transicoes byte a byte a partir da tabela achatada (simbolos eh
+// o texto de cada id, pra contar bytes e quebras de linha de cada transicao)
+// Fica vazia quando a arvore nao cabe em 16 bits ou so tem um simbolo
+// Complexidade: O(n * 256 * 8)
+std::vector<TransicaoByte> construirTransicoes(const std::vector<NoDecodificacao>& nos,
+                                               const std::vector<std::string>& simbolos);
+
 class HuffmanTree {
 private:
     std::shared_ptr<HuffmanNode> raiz;
     std::map<std::string, std::string> codigos; 
+    std::vector<std::string> simbolos;            // id -> simbolo, na ordem da tabela
+    std::vector<NoDecodificacao> tabelaDecodificacao; // no 0 eh a raiz
     
     // Gera os codigos percorrendo a arvore
     // Complexidade: O(n) onde n e o numero de nos
     void gerarCodigos(std::shared_ptr<HuffmanNode> node, const std::string& code);
     
+    // Copia a arvore pra tabelaDecodificacao em pre-ordem, retorna o indice do no
+    int achatarArvore(const std::shared_ptr<HuffmanNode>& node);
+    
 public:
     HuffmanTree() : raiz(nullptr) {}
     
@@ -51,6 +87,11 @@ public:
     
     std::shared_ptr<HuffmanNode> obterRaiz() const { return raiz; }
     
+    // Cada simbolo tem um id (posicao na ordem da tabela de frequencias)
+    const std::vector<std::string>& obterSimbolos() const { return simbolos; }
+    
+    const std::vector<NoDecodificacao>& obterTabelaDecodificacao() const { return tabelaDecodificacao; }
+    
     void imprimirArvore(std::shared_ptr<HuffmanNode> node = nullptr, int depth = 0) const;
     
     void imprimirCodigos() const;
@@ -0,0 +1,202 @@
+#include "modelo.hpp"
+#include "crc32c.hpp"
+#include <algorithm>
+#include <cmath>
+#include <fstream>
+#include <iostream>
+
+int Modelo::obterId(std::string_view simbolo) const {
+    auto it = std::lower_bound(simbolos.begin(), simbolos.end(), simbolo,
+                               [](const std::string& a, std::string_view b) { return std::string_view(a) < b; });
+    if (it == simbolos.end() || *it != simbolo) return -1;
+    return static_cast<int>(it - simbolos.begin());
+}
+
+const std::vector<TransicaoByte>& Modelo::obterTransicoes() const {
+    if (!transicoesProntas) {
+        transicoes = construirTransicoes(nos, simbolos);
+        transicoesProntas = true;
+    }
+    return transicoes;
+}
+
+const TabelaTans& Modelo::obterTans() const {
+    if (!tansPronta) {
+        construirTabelaTans(frequencias, tans);
+        tansPronta = true;
+    }
+    return tans;
+}
+
+TabelasFrequencias carregarPacoteFrequencias(const std::string& filename) {
+    TabelasFrequencias tabelas;
+    std::ifstream file(filename);
+    
+    if (!file.is_open()) {
+        std::cerr << "Erro ao abrir arquivo de frequências: " << filename << std::endl;
+        return tabelas;
+    }
+    
+    std::string line;
+    while (std::getline(file, line)) {
+        // Linha sem '|' no formato [nome] comeca um modelo novo
+        // (o '|' dos simbolos sempre aparece, entao nao tem ambiguidade)
+        size_t pos = line.find('|');
+        if (pos == std::string::npos && line.size() >= 2 && line.front() == '[' && line.back() == ']') {
+            tabelas.emplace_back(line.substr(1, line.size() - 2), std::map<std::string, int>());
+            continue;
+        }
+        if (pos != std::string::npos) {
+            std::string symbol = line.substr(0, pos);
+            int frequency = std::stoi(line.substr(pos + 1));
+            
+            // Desescapa caracteres especiais
+            if (symbol == "\\n") symbol = "\n";
+            else if (symbol == "\\t") symbol = "\t";
+            else if (symbol == "\\s") symbol = " ";
+            else if (symbol == "\\p") symbol = "|";
+            
+            if (tabelas.empty()) tabelas.emplace_back("", std::map<std::string, int>());
+            tabelas.back().second[symbol] = frequency;
+        }
+    }
+    
+    file.close();
+    
+    // Modelo sem nenhum simbolo nao serve pra nada
+    tabelas.erase(std::remove_if(tabelas.begin(), tabelas.end(),
+                                 [](const auto& tabela) { return tabela.second.empty(); }),
+                  tabelas.end());
+    return tabelas;
+}
+
+std::map<std::string, int> carregarTabelaFrequencias(const std::string& filename) {
+    std::map<std::string, int> frequencies;
+    for (const auto& tabela : carregarPacoteFrequencias(filename)) {
+        for (const auto& pair : tabela.second) {
+            frequencies[pair.first] += pair.second;
+        }
+    }
+    return frequencies;
+}
+
+bool criarModelo(const HuffmanTree& tree, const std::map<std::string, int>& frequencies,
+                 Modelo& modelo) {
+    modelo.simbolos = tree.obterSimbolos();
+    modelo.nos = tree.obterTabelaDecodificacao();
+    modelo.codigos.clear();
+    modelo.frequencias.clear();
+    
+    // Converte os codigos "0101" da arvore pra inteiro
+    const auto& codigos = tree.obterCodigos();
+    for (const auto& simbolo : modelo.simbolos) {
+        const std::string& texto = codigos.at(simbolo);
+        if (texto.length() > 64) return false;
+        
+        CodigoHuffman codigo{0, static_cast<uint8_t>(texto.length())};
+        for (char bit : texto) {
+            codigo.bits = (codigo.bits << 1) | (bit == '1');
+        }
+        modelo.codigos.push_back(codigo);
+        modelo.frequencias.push_back(static_cast<uint32_t>(std::max(1, frequencies.at(simbolo))));
+    }
+    
+    completarModelo(modelo);
+    modelo.id = calcularIdModelo(modelo);
+    return true;
+}
+
+void completarModelo(Modelo& modelo) {
+    modelo.idPorByte.assign(256, -1);
+    for (size_t i = 0; i < modelo.simbolos.size(); ++i) {
+        if (modelo.simbolos[i].length() == 1) {
+            modelo.idPorByte[static_cast<unsigned char>(modelo.simbolos[i][0])] = static_cast<int>(i);
+        }
+    }
+    modelo.transicoes.clear();
+    modelo.transicoesProntas = false;
+    modelo.tans = TabelaTans();
+    modelo.tansPronta = false;
+    
+    // Custo por byte: os bits de cada simbolo (frequencia x tamanho do codigo)
+    // divididos igualmente entre os bytes dele, e depois pela quantidade de
+    // vezes que o byte aparece
+    // Byte sem simbolo proprio nao pode ser codificado: custo infinito pro
+    // bloco que tem ele nunca escolher esse modelo se outro servir
+    // Palavra com frequencia 1 fica de fora: eh a que so entrou pra completar
+    // o pacote, e num modelo pequeno ela barateava as letras dela
+    std::vector<double> bits(256, 0.0), ocorrencias(256, 0.0);
+    for (size_t i = 0; i < modelo.simbolos.size(); ++i) {
+        const std::string& simbolo = modelo.simbolos[i];
+        double f = modelo.frequencias.empty() ? 1.0 : modelo.frequencias[i];
+        if (simbolo.length() > 1 && f <= 1.0) continue;
+        for (unsigned char c : simbolo) {
+            bits[c] += f * modelo.codigos[i].tamanho / simbolo.length();
+            ocorrencias[c] += f;
+        }
+    }
+    modelo.custoPorByte.assign(256, HUGE_VALF);
+    for (int b = 0; b < 256; ++b) {
+        if (modelo.idPorByte[b] >= 0) {
+            modelo.custoPorByte[b] = static_cast<float>(bits[b] / ocorrencias[b]);
+        }
+    }
+}
+
+uint32_t calcularIdModelo(const Modelo& modelo) {
+    uint32_t crc = 0;
+    for (size_t i = 0; i < modelo.simbolos.size(); ++i) {
+        uint32_t tamanho = static_cast<uint32_t>(modelo.simbolos[i].length());
+        crc = calcularCrc32c(&tamanho, sizeof(tamanho), crc);
+        crc = calcularCrc32c(modelo.simbolos[i].data(), tamanho, crc);
+        crc = calcularCrc32c(&modelo.codigos[i].bits, sizeof(modelo.codigos[i].bits), crc);
+        crc = calcularCrc32c(&modelo.codigos[i].tamanho, sizeof(modelo.codigos[i].tamanho), crc);
+        crc = calcularCrc32c(&modelo.frequencias[i], sizeof(modelo.frequencias[i]), crc);
+    }
+    return crc;
+}
+
+bool criarPacote(const TabelasFrequencias& tabelas, PacoteModelos& pacote) {
+    pacote = PacoteModelos();
+    if (tabelas.empty() || tabelas.size() > MAX_MODELOS) return false;
+    
+    // Todo modelo recebe os simbolos dos outros (com frequencia 1), como o
+    // frequency_counter ja faz: assim o texto eh tokenizado igual seja qual for
+    // o modelo do bloco (e os ids de cada simbolo sao os mesmos em todos)
+    std::map<std::string, int> todos;
+    for (const auto& tabela : tabelas) {
+        for (const auto& pair : tabela.second) todos.emplace(pair.first, 1);
+    }
+    
+    for (const auto& tabela : tabelas) {
+        std::map<std::string, int> frequencies = tabela.second;
+        frequencies.insert(todos.begin(), todos.end());
+        HuffmanTree tree;
+        tree.construirArvore(frequencies);
+        Modelo modelo;
+        if (!tree.obterRaiz() || !criarModelo(tree, frequencies, modelo)) return false;
+        
+        pacote.nomes.push_back(tabela.first);
+        pacote.modelos.push_back(std::move(modelo));
+    }
+    pacote.id = calcularIdPacote(pacote);
+    return true;
+}
+
+uint32_t calcularIdPacote(const PacoteModelos& pacote) {
+    if (pacote.modelos.size() == 1) return pacote.modelos[0].id;
+    
+    uint32_t crc = 0;
+    for (const auto& modelo : pacote.modelos) {
+        crc = calcularCrc32c(&modelo.id, sizeof(modelo.id), crc);
+    }
+    return crc;
+}
+
+double estimarCusto(const Modelo& modelo, const uint32_t histograma[256]) {
+    double custo = 0.0;
+    for (int b = 0; b < 256; ++b) {
+        if (histograma[b] > 0) custo += histograma[b] * static_cast<double>(modelo.custoPorByte[b]);
+    }
+    return custo;
+}
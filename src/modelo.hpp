@@ -0,0 +1,98 @@
+#ifndef MODELO_HPP
+#define MODELO_HPP
+
+#include "huffman_tree.hpp"
+#include "tans.hpp"
+#include <cstdint>
+#include <map>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Codigo de um simbolo guardado em inteiro: os 'tamanho' bits mais baixos
+// de 'bits', com o primeiro bit do codigo na posicao mais alta
+struct CodigoHuffman {
+    uint64_t bits;
+    uint8_t tamanho;
+};
+
+// Tudo que o compressor precisa pra codificar e decodificar: simbolos,
+// codigos e tabelas de decodificacao, indexados pelo id do simbolo
+// Pode vir de uma tabela de frequencias (via HuffmanTree) ou das tabelas
+// constexpr do modelo padrao, geradas na compilacao
+struct Modelo {
+    uint32_t id = 0;                           // identifica o modelo no cabecalho do .huf
+    std::vector<std::string> simbolos;         // em ordem crescente (mesma do std::map)
+    std::vector<CodigoHuffman> codigos;
+    std::vector<uint32_t> frequencias;         // da tabela, usadas pelo tANS
+    std::vector<NoDecodificacao> nos;          // arvore achatada, no 0 eh a raiz
+    std::vector<int> idPorByte = std::vector<int>(256, -1);  // simbolos de um caractere
+    std::vector<float> custoPorByte;           // bits estimados por byte do texto
+
+    // Id do simbolo ou -1 se ele nao esta no modelo
+    // Busca binaria nos simbolos ordenados, sem montar std::string
+    int obterId(std::string_view simbolo) const;
+
+    // Transicoes byte a byte ([no * 256 + byte]) e tabela do tANS, montadas
+    // na primeira vez que sao pedidas: um pacote pode ter centenas de modelos
+    // que nenhum bloco usa, e a compressao nunca usa as transicoes
+    // Nao eh thread-safe: so a thread que codifica ou decodifica os blocos pede
+    const std::vector<TransicaoByte>& obterTransicoes() const;
+    const TabelaTans& obterTans() const;
+
+    // Cache das tabelas acima
+    mutable std::vector<TransicaoByte> transicoes;
+    mutable bool transicoesProntas = false;
+    mutable TabelaTans tans;
+    mutable bool tansPronta = false;
+};
+
+// Varios modelos usados no mesmo arquivo, um por categoria de fonte
+// (extensao, diretorio ou grupo de histogramas parecidos); cada bloco do
+// .huf diz qual deles usou
+struct PacoteModelos {
+    uint32_t id = 0;                           // vai no cabecalho do .huf
+    std::vector<std::string> nomes;
+    std::vector<Modelo> modelos;
+};
+
+// Maximo de modelos num pacote (o indice do modelo no bloco eh um uint8)
+const size_t MAX_MODELOS = 255;
+
+// Tabela de frequencias de cada modelo do pacote, com o nome
+using TabelasFrequencias = std::vector<std::pair<std::string, std::map<std::string, int>>>;
+
+// Le o pacote de tabelas (formato simbolo|frequencia, cada modelo comecando
+// com uma linha [nome]); uma tabela comum vira um pacote de um modelo so
+TabelasFrequencias carregarPacoteFrequencias(const std::string& filename);
+
+// Le a tabela de frequencias do arquivo, somando os modelos se for um pacote
+std::map<std::string, int> carregarTabelaFrequencias(const std::string& filename);
+
+// Monta o modelo a partir de uma arvore ja construida com essas frequencias
+// Retorna false se algum codigo passar de 64 bits
+bool criarModelo(const HuffmanTree& tree, const std::map<std::string, int>& frequencies,
+                 Modelo& modelo);
+
+// Preenche idPorByte e o custo por byte depois que simbolos, frequencias e
+// nos estao prontos (as outras tabelas sao montadas quando forem usadas)
+void completarModelo(Modelo& modelo);
+
+// CRC32C dos simbolos, codigos e frequencias: dois modelos com o mesmo id
+// codificam igual nos dois backends
+uint32_t calcularIdModelo(const Modelo& modelo);
+
+// Monta um modelo por tabela, todos com os mesmos simbolos (o que falta numa
+// tabela entra com frequencia 1); retorna false se alguma arvore for invalida
+bool criarPacote(const TabelasFrequencias& tabelas, PacoteModelos& pacote);
+
+// Id do pacote: o do modelo, se for um so, ou o CRC32C dos ids dos modelos
+uint32_t calcularIdPacote(const PacoteModelos& pacote);
+
+// Estimativa rapida de quantos bits o modelo gasta num texto com esse
+// histograma de bytes (produto com custoPorByte, sem tokenizar)
+// Da infinito se o texto tem byte que o modelo nao codifica
+double estimarCusto(const Modelo& modelo, const uint32_t histograma[256]);
+
+#endif // MODELO_HPP
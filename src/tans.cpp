@@ -0,0 +1,165 @@
+#include "tans.hpp"
+#include <algorithm>
+#include <utility>
+
+namespace {
+
+const int BITS_ESTADO_MIN = 11;
+const int BITS_ESTADO_MAX = 15;
+
+// Posicao do bit mais alto (floor(log2(v))), v > 0
+int bitMaisAlto(uint32_t v) {
+    return 31 - __builtin_clz(v);
+}
+
+// Normaliza as frequencias pra somarem exatamente L, sem zerar nenhuma
+// O que sobra (ou falta) por causa do arredondamento vai pros maiores
+std::vector<uint32_t> normalizar(const std::vector<uint32_t>& frequencias, uint32_t L) {
+    uint64_t total = 0;
+    for (uint32_t f : frequencias) total += f;
+
+    std::vector<uint32_t> norm(frequencias.size());
+    int64_t soma = 0;
+    for (size_t i = 0; i < frequencias.size(); ++i) {
+        uint64_t proporcional = (static_cast<uint64_t>(frequencias[i]) * L + total / 2) / total;
+        norm[i] = static_cast<uint32_t>(std::max<uint64_t>(1, proporcional));
+        soma += norm[i];
+    }
+
+    size_t maior = std::max_element(norm.begin(), norm.end()) - norm.begin();
+    if (soma < L) {
+        norm[maior] += static_cast<uint32_t>(L - soma);
+    }
+    while (soma > L) {
+        // Tira aos poucos do maior, que eh quem menos perde com isso
+        // (com L >= n sempre sobra algum maior que 1 enquanto soma > L)
+        maior = std::max_element(norm.begin(), norm.end()) - norm.begin();
+        int64_t tirar = std::min<int64_t>({soma - L, norm[maior] / 16 + 1, norm[maior] - 1});
+        norm[maior] -= static_cast<uint32_t>(tirar);
+        soma -= tirar;
+    }
+    return norm;
+}
+
+// Grava os bits (valor, quantidade) com o primeiro bit na posicao mais alta
+struct EscritorBits {
+    std::vector<unsigned char>& saida;
+    uint64_t acumulador = 0;
+    int pendentes = 0;
+    size_t total = 0;
+
+    explicit EscritorBits(std::vector<unsigned char>& saida) : saida(saida) {}
+
+    void escrever(uint32_t valor, int n) {
+        acumulador = (acumulador << n) | valor;
+        pendentes += n;
+        total += n;
+        while (pendentes >= 8) {
+            pendentes -= 8;
+            saida.push_back(static_cast<unsigned char>(acumulador >> pendentes));
+        }
+    }
+
+    void terminar() {
+        if (pendentes > 0) {
+            saida.push_back(static_cast<unsigned char>(acumulador << (8 - pendentes)));
+            pendentes = 0;
+        }
+    }
+};
+
+} // namespace
+
+bool cabeNoTans(size_t numSimbolos) {
+    return numSimbolos > 0 && numSimbolos <= (size_t(1) << BITS_ESTADO_MAX);
+}
+
+bool construirTabelaTans(const std::vector<uint32_t>& frequencias, TabelaTans& tabela) {
+    tabela = TabelaTans();
+    size_t n = frequencias.size();
+    if (!cabeNoTans(n)) return false;
+
+    // Pelo menos ~32 estados por simbolo: com menos, os simbolos raros (que
+    // ficam com 1 estado no minimo) roubam probabilidade demais dos comuns
+    int R = BITS_ESTADO_MIN;
+    while (R < BITS_ESTADO_MAX && (size_t(1) << R) < 32 * n) ++R;
+    uint32_t L = uint32_t(1) << R;
+    std::vector<uint32_t> norm = normalizar(frequencias, L);
+
+    // Espalha os simbolos pela tabela com o passo do FSE (impar, entao passa
+    // por todos os L estados), intercalando os de cada simbolo
+    std::vector<uint16_t> simboloDoEstado(L);
+    uint32_t passo = (L >> 1) + (L >> 3) + 3;
+    uint32_t pos = 0;
+    for (size_t s = 0; s < n; ++s) {
+        for (uint32_t i = 0; i < norm[s]; ++i) {
+            simboloDoEstado[pos] = static_cast<uint16_t>(s);
+            pos = (pos + passo) & (L - 1);
+        }
+    }
+
+    // Decodificador: o k-esimo estado de s (k de f ate 2f-1) volta pra faixa [L, 2L)
+    tabela.bitsEstado = R;
+    tabela.decodificacao.resize(L);
+    std::vector<uint32_t> proximo(norm);
+    for (uint32_t u = 0; u < L; ++u) {
+        uint16_t s = simboloDoEstado[u];
+        uint32_t v = proximo[s]++;
+        int bits = R - bitMaisAlto(v);
+        tabela.decodificacao[u] = {s, static_cast<uint8_t>(bits), static_cast<uint16_t>((v << bits) - L)};
+    }
+
+    // Codificador: os estados de cada simbolo ficam juntos, na mesma ordem
+    // em que o decodificador os numerou
+    tabela.estados.resize(L);
+    tabela.simbolos.resize(n);
+    std::vector<uint32_t> inicio(n);
+    uint32_t acumulado = 0;
+    for (size_t s = 0; s < n; ++s) {
+        inicio[s] = acumulado;
+        acumulado += norm[s];
+
+        uint32_t f = norm[s];
+        SimboloTans& simbolo = tabela.simbolos[s];
+        if (f == 1) {
+            simbolo.deltaBits = (static_cast<uint32_t>(R) << 16) - L;
+        } else {
+            uint32_t maxBits = R - bitMaisAlto(f - 1);
+            simbolo.deltaBits = (maxBits << 16) - (f << maxBits);
+        }
+        simbolo.deltaEstado = static_cast<int32_t>(inicio[s]) - static_cast<int32_t>(f);
+    }
+    for (uint32_t u = 0; u < L; ++u) {
+        tabela.estados[inicio[simboloDoEstado[u]]++] = static_cast<uint16_t>(L + u);
+    }
+    return true;
+}
+
+size_t codificarTans(const TabelaTans& tabela, const std::vector<int>& ids,
+                     std::vector<unsigned char>& saida) {
+    uint32_t L = uint32_t(1) << tabela.bitsEstado;
+    std::vector<std::pair<uint16_t, uint8_t>> pedacos(ids.size());
+
+    // Estado em [L, 2L); comeca (e o decodificador termina) em L
+    uint32_t estado = L;
+    for (size_t i = ids.size(); i-- > 0; ) {
+        const SimboloTans& s = tabela.simbolos[ids[i]];
+        uint32_t bits = (estado + s.deltaBits) >> 16;
+        pedacos[i] = {static_cast<uint16_t>(estado & ((uint32_t(1) << bits) - 1)), static_cast<uint8_t>(bits)};
+        estado = tabela.estados[static_cast<int32_t>(estado >> bits) + s.deltaEstado];
+    }
+
+    saida.clear();
+    saida.reserve(ids.size() + 8);
+    uint32_t quantidade = static_cast<uint32_t>(ids.size());
+    saida.resize(sizeof(quantidade));
+    std::memcpy(saida.data(), &quantidade, sizeof(quantidade));
+
+    EscritorBits escritor(saida);
+    escritor.escrever(estado - L, tabela.bitsEstado);
+    for (const auto& pedaco : pedacos) {
+        escritor.escrever(pedaco.first, pedaco.second);
+    }
+    escritor.terminar();
+    return 8 * sizeof(quantidade) + escritor.total;
+}
@@ -0,0 +1,91 @@
+#ifndef TANS_HPP
+#define TANS_HPP
+
+#include <cstddef>
+#include <cstdint>
+#include <cstring>
+#include <vector>
+
+// Codificador tANS (asymmetric numeral systems com tabela, igual ao FSE)
+// As frequencias dos simbolos sao normalizadas pra somar L = 2^bitsEstado e
+// espalhadas numa tabela de L estados; cada simbolo custa ~log2(L/f) bits,
+// fracionario, em vez do inteiro arredondado do Huffman
+// Os simbolos sao os mesmos ids do Modelo (mesma tokenizacao)
+
+// Estado do decodificador: simbolo emitido e como chegar no proximo estado
+struct EntradaTans {
+    uint16_t simbolo;
+    uint8_t bits;         // quantos bits ler do fluxo
+    uint16_t base;        // proximo estado = base + bits lidos
+};
+
+// Parametros do codificador por simbolo (truque do FSE pra achar quantos
+// bits sair sem laco: bits = (estado + deltaBits) >> 16)
+struct SimboloTans {
+    uint32_t deltaBits;
+    int32_t deltaEstado;
+};
+
+struct TabelaTans {
+    int bitsEstado = 0;                   // R, com L = 2^R estados
+    std::vector<EntradaTans> decodificacao;  // [estado], estado em [0, L)
+    std::vector<uint16_t> estados;        // proximo estado do codificador, em [L, 2L)
+    std::vector<SimboloTans> simbolos;    // [id]
+};
+
+// Se da pra montar uma tabela com essa quantidade de simbolos
+bool cabeNoTans(size_t numSimbolos);
+
+// Monta a tabela a partir das frequencias (uma por id, todas > 0)
+// Retorna false se nao tiver simbolo ou se eles nao couberem em 2^15 estados
+bool construirTabelaTans(const std::vector<uint32_t>& frequencias, TabelaTans& tabela);
+
+// Codifica os ids em saida; retorna a quantidade de bits validos
+// Formato: quantidade de simbolos (uint32), estado final (R bits) e os bits
+// de cada simbolo, na ordem em que o decodificador le
+// Os simbolos sao codificados de tras pra frente (o tANS eh uma pilha), entao
+// os bits sao guardados e escritos invertidos no fim
+size_t codificarTans(const TabelaTans& tabela, const std::vector<int>& ids,
+                     std::vector<unsigned char>& saida);
+
+// Decodifica totalBits bits de dados chamando emitir(id) a cada simbolo
+// Falha se os bits acabarem antes, sobrarem, ou o estado final nao for o
+// inicial do codificador (tabela errada ou arquivo corrompido)
+template <typename Emitir>
+bool decodificarTans(const TabelaTans& tabela, const unsigned char* dados, size_t totalBits,
+                     Emitir emitir) {
+    if (totalBits < 32 || tabela.decodificacao.empty()) return false;
+    uint32_t quantidade;
+    std::memcpy(&quantidade, dados, sizeof(quantidade));
+
+    // Leitor de bits: acumulador de 64 bits reabastecido byte a byte
+    size_t proximoByte = 4;
+    size_t restantes = totalBits - 32;
+    uint64_t acumulador = 0;
+    int bitsNoAcumulador = 0;
+    auto ler = [&](int n, uint32_t& valor) {
+        if (static_cast<size_t>(n) > restantes) return false;
+        while (bitsNoAcumulador < n) {
+            acumulador = (acumulador << 8) | dados[proximoByte++];
+            bitsNoAcumulador += 8;
+        }
+        bitsNoAcumulador -= n;
+        valor = static_cast<uint32_t>(acumulador >> bitsNoAcumulador) & ((uint32_t(1) << n) - 1);
+        restantes -= n;
+        return true;
+    };
+
+    uint32_t estado;
+    if (!ler(tabela.bitsEstado, estado)) return false;
+    const EntradaTans* d = tabela.decodificacao.data();
+    for (uint32_t i = 0; i < quantidade; ++i) {
+        const EntradaTans& e = d[estado];
+        emitir(static_cast<int>(e.simbolo));
+        uint32_t bits;
+        if (!ler(e.bits, bits)) return false;
+        estado = e.base + bits;
+    }
+    return restantes == 0 && estado == 0;
+}
+
+#endif // TANS_HPP